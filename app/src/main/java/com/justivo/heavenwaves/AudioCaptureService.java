@@ -18,12 +18,19 @@ import android.media.AudioRecord;
 import android.media.projection.MediaProjection;
 import android.media.projection.MediaProjectionManager;
 import android.os.Build;
+import android.os.Handler;
 import android.os.IBinder;
+import android.os.Looper;
 import android.util.Log;
 
 import androidx.core.app.NotificationCompat;
 
+import org.freedesktop.gstreamer.GStreamer;
+
 import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.Iterator;
+import java.util.List;
 import java.util.Objects;
 
 public class AudioCaptureService extends Service {
@@ -31,6 +38,17 @@ public class AudioCaptureService extends Service {
 
     private static final String ACTION_START = "AudioCaptureService:Start";
     private static final String ACTION_STOP = "AudioCaptureService:Stop";
+    // Warm standby: capture stops but the pipeline stays prerolled in PAUSED
+    private static final String ACTION_PAUSE = "AudioCaptureService:Pause";
+    private static final String ACTION_RESUME = "AudioCaptureService:Resume";
+    // Receiver changes applied to the running stream without restarting it
+    private static final String ACTION_ADD_DESTINATION = "AudioCaptureService:AddDestination";
+    private static final String ACTION_REMOVE_DESTINATION = "AudioCaptureService:RemoveDestination";
+    private static final String ACTION_SET_PORT = "AudioCaptureService:SetPort";
+    private static final String ACTION_SET_ENCODER_PROFILE = "AudioCaptureService:SetEncoderProfile";
+    // Another encode of the same capture, e.g. a low-bitrate WAN stream
+    // next to the LAN one
+    private static final String ACTION_ADD_SESSION = "AudioCaptureService:AddSession";
     private static final String CHANNEL_ID = "HeavenWavesAudioCaptureChannel";
     private static final int NOTIFICATION_ID = 1;
 
@@ -41,20 +59,143 @@ public class AudioCaptureService extends Service {
     private static final int BUFFER_SIZE_MULTIPLIER = 2;
     private static final int NUM_CHANNELS = 2; // Stereo
 
+    // Audio buffered natively between the capture thread and GStreamer
+    private static final int RING_CAPACITY_MS = 200;
+
+    // Periods read and fed per JNI call in power-save mode
+    private static final int POWER_SAVE_BATCH_PERIODS = 4;
+
+    // What the native side drops when the pipeline can't keep up:
+    // "block", "drop-oldest", "drop-newest" or "adaptive"
+    private static final String BACKPRESSURE_POLICY = "drop-oldest";
+
+    // Opus encoder preset: "ultra-low-latency", "balanced", "lossy-link", "low-cpu" or "default"
+    private static final String DEFAULT_ENCODER_PROFILE = "balanced";
+
+    // Hops a multicast stream may cross; 1 keeps it on the local network
+    private static final int DEFAULT_MULTICAST_TTL = 1;
+
+    // How far back NACKed packets can still be retransmitted
+    private static final int RTX_HISTORY_MS = 500;
+
+    // Local TCP server: port and what a client too slow to keep up gets,
+    // "drop" (skip to the newest audio) or "disconnect"
+    private static final int TCP_SERVER_PORT = 5006;
+
+    // Extra sessions get their own RTP/RTCP port pair, from here up
+    private static final int FIRST_EXTRA_SESSION_PORT = 5008;
+    private static final String TCP_SLOW_CLIENT_POLICY = "drop";
+
+    // RTP socket QoS: DSCP EF (46) maps to the WMM voice queue, a modest
+    // send buffer bounds queueing delay, and packets are never fragmented
+    private static final int SOCKET_DSCP = 46;
+    private static final int SOCKET_BUFFER_SIZE = 64 * 1024;
+    private static final String DONT_FRAGMENT = "do";
+
+    // Audio per RTP packet: encoder frames shorter than this are aggregated,
+    // so 5 ms frames still go out at 100 packets/s
+    private static final int RTP_PTIME_MS = 10;
+    private static final int RTP_MTU = 1400;
+
+    // Longest a stop may spend draining before the pipeline is forced down
+    private static final int STOP_DEADLINE_MS = 3000;
+
+    // Lowest bitrate the RTCP-driven controller may fall back to
+    private static final int MIN_ADAPTIVE_BITRATE = 32000;
+
+    // Indices into nativeGetStats()
+    private static final int STAT_POOL_HITS = 0;
+    private static final int STAT_POOL_MISSES = 1;
+    private static final int STAT_POOL_GROWTH = 2;
+    private static final int STAT_RING_OVERRUNS = 3;
+    private static final int STAT_RING_UNDERRUNS = 4;
+    private static final int STAT_DISCONTINUITIES = 5;
+    private static final int STAT_DROPPED_BUFFERS = 6;
+    private static final int STAT_DROPPED_SAMPLES = 7;
+    private static final int STAT_DROPPED_DURATION_NS = 8;
+    private static final int STAT_ENCODER_BITRATE = 9;
+    private static final int STAT_RTCP_FRACTION_LOST = 10;
+    private static final int STAT_RTCP_JITTER_US = 11;
+    private static final int STAT_NACKS_RECEIVED = 12;
+    private static final int STAT_RTX_PACKETS = 13;
+    private static final int STAT_RTX_HISTORY_MISSES = 14;
+    private static final int STAT_EGRESS_SYSCALLS = 15;
+    private static final int STAT_EGRESS_SYSCALLS_PER_SECOND = 16;
+    private static final int STAT_TCP_CLIENTS = 17;
+    private static final int STAT_TCP_MAX_LAG_MS = 18;
+    private static final int STAT_SEND_EAGAIN = 19;
+    private static final int STAT_SEND_ENOBUFS = 20;
+    private static final int STAT_RTP_PACKET_RATE = 21;
+    private static final int STAT_RTP_OVERHEAD_PERMILLE = 22;
+    private static final int STAT_TIME_TO_FIRST_PACKET_US = 23;
+    private static final int STAT_INIT_CREATE_US = 24;
+    private static final int STAT_INIT_LINK_US = 25;
+    private static final int STAT_INIT_CONFIGURE_US = 26;
+    private static final int STAT_START_US = 27;
+    private static final int STAT_COLD_START_US = 28;
+
+    // Event types passed to onPipelineEvents()
+    private static final int EVENT_ERROR = 0;
+    private static final int EVENT_WARNING = 1;
+    private static final int EVENT_EOS = 2;
+    private static final int EVENT_LATENCY = 3;
+    private static final int EVENT_QOS = 4;
+    private static final int EVENT_DROPPED = 5;
+
+    private final Handler mainHandler = new Handler(Looper.getMainLooper());
+
     private MediaProjectionManager mediaProjectionManager;
     private MediaProjection mediaProjection;
     private AudioRecord audioRecord;
     private Thread captureThread;
     private volatile boolean isCapturing = false;
+    private boolean isPaused = false;
+    // Native session handles; 0 means no session. The capture thread feeds
+    // the main session, which copies each period to the extra ones.
+    private volatile long session = 0;
+    private final List<Long> extraSessions = new ArrayList<>();
+    // Next default port pair for an extra session. Only ever moves up, so a
+    // new session can't land on the ports of a live or still stopping one.
+    private int nextExtraSessionPort = FIRST_EXTRA_SESSION_PORT;
+    // A new pipeline may need the sockets of stops still draining natively,
+    // so while any are left its start waits (see startPendingPipeline)
+    private boolean pipelineStartPending = false;
+    private final Runnable pendingStartCheck = this::startPendingPipeline;
+    private String pipelineOutputPath = "";
+    private int captureBufferSize = 0;
     private String streamHost = "127.0.0.1";
     private boolean saveToFile = false;
+    private boolean powerSave = false;
+    private String encoderProfile = DEFAULT_ENCODER_PROFILE;
+    private boolean retransmission = false;
+    private boolean batchedEgress = false;
+    private String tcpServerMode = "none";
+    private String multicastGroup = null;
+    private int multicastTtl = DEFAULT_MULTICAST_TTL;
+    private String multicastInterface = null;
 
     // Native method declarations for GStreamer pipeline
-    private native boolean nativeInitPipeline(String host, int sampleRate, int channels, String outputPath, int bitrate);
-    private native boolean nativeFeedAudioData(byte[] buffer, int size);
-    private native boolean nativeStartPipeline();
-    private native void nativeStopPipeline();
-    private native String nativeGetLastError();
+    private native long nativeInitPipeline(String host, int sampleRate, int channels, String format, String outputPath, int bitrate, int periodSize, String options);
+    private native boolean nativeFeedAudioData(long session, byte[] buffer, int size);
+    private native boolean nativeFeedDirectBuffer(long session, ByteBuffer buffer, int size);
+    private native boolean nativeFeedDirectBatch(long session, ByteBuffer buffer, int size, int periodSize);
+    private native ByteBuffer nativeAcquireDirectBuffer(long session);
+    private native boolean nativeStartPipeline(long session);
+    private native boolean nativePause(long session);
+    private native boolean nativeResume(long session);
+    private native boolean nativeStopPipelineAsync(long session, int deadlineMs);
+    private native String nativeGetLastError(long session);
+    private native String nativeGetPipelineReport(long session);
+    private native long[] nativeGetStats(long session);
+    private native boolean nativeAddDestination(long session, String host);
+    private native boolean nativeRemoveDestination(long session, String host);
+    private native boolean nativeSetPort(long session, int port);
+    private native boolean nativeSetEncoderProfile(long session, String profile);
+    private native String nativeGetReceiverPipeline(long session);
+    private native String nativeGetClientReport(long session);
+    private native boolean nativeAddMirror(long session, long mirror);
+    private native int nativeGetSessionCount();
+    private native int nativeGetPendingStops();
 
     // Load native library
     static {
@@ -86,6 +227,64 @@ public class AudioCaptureService extends Service {
             return START_NOT_STICKY;
         }
 
+        if (Objects.equals(intent.getAction(), ACTION_PAUSE)) {
+            pauseAudioCapture();
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_RESUME)) {
+            resumeAudioCapture();
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_ADD_DESTINATION)) {
+            String host = intent.getStringExtra("HOST");
+            if (!isCapturing || host == null || !nativeAddDestination(session, host)) {
+                Log.w(TAG, "Could not add destination " + host);
+            }
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_REMOVE_DESTINATION)) {
+            String host = intent.getStringExtra("HOST");
+            if (!isCapturing || host == null || !nativeRemoveDestination(session, host)) {
+                Log.w(TAG, "Could not remove destination " + host);
+            }
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_SET_PORT)) {
+            int port = intent.getIntExtra("PORT", 0);
+            if (!isCapturing || !nativeSetPort(session, port)) {
+                Log.w(TAG, "Could not move destinations to port " + port);
+            }
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_SET_ENCODER_PROFILE)) {
+            String profile = intent.getStringExtra("ENCODER_PROFILE");
+            if (!isCapturing || profile == null || !nativeSetEncoderProfile(session, profile)) {
+                Log.w(TAG, "Could not switch to encoder profile " + profile);
+            } else {
+                encoderProfile = profile;
+                Log.i(TAG, "Receiver pipeline: " + nativeGetReceiverPipeline(session));
+            }
+            return START_STICKY;
+        }
+
+        if (Objects.equals(intent.getAction(), ACTION_ADD_SESSION)) {
+            String host = intent.getStringExtra("HOST");
+            String profile = intent.getStringExtra("ENCODER_PROFILE");
+            int port = intent.hasExtra("PORT") ? intent.getIntExtra("PORT", 0) : nextExtraSessionPort;
+            if (port >= nextExtraSessionPort) {
+                nextExtraSessionPort = port + 2;
+            }
+            if (!isCapturing || host == null || !addSession(host, profile != null ? profile : encoderProfile, port)) {
+                Log.w(TAG, "Could not add a session streaming to " + host + ":" + port);
+            }
+            return START_STICKY;
+        }
+
         if (intent.hasExtra("MEDIA_PROJECTION")) {
             // Get host from intent if provided
             if (intent.hasExtra("HOST")) {
@@ -99,6 +298,34 @@ public class AudioCaptureService extends Service {
                 Log.i(TAG, "Save to file: " + saveToFile);
             }
 
+            // Power-save mode reads several periods per JNI call
+            powerSave = intent.getBooleanExtra("POWER_SAVE", false);
+
+            // NACK-driven retransmission for links with occasional bursts
+            retransmission = intent.getBooleanExtra("RTX", false);
+
+            // Send RTP through the sendmmsg/GSO sink instead of multiudpsink
+            batchedEgress = intent.getBooleanExtra("BATCHED_EGRESS", false);
+
+            // Serve the same encode to TCP clients: "rtp" (RFC 4571), "ogg" or "none"
+            if (intent.hasExtra("TCP_SERVER")) {
+                tcpServerMode = intent.getStringExtra("TCP_SERVER");
+                Log.i(TAG, "TCP server: " + tcpServerMode);
+            }
+
+            // Multicast mode sends to a group instead of HOST
+            multicastGroup = intent.getStringExtra("MULTICAST_GROUP");
+            multicastTtl = intent.getIntExtra("MULTICAST_TTL", DEFAULT_MULTICAST_TTL);
+            multicastInterface = intent.getStringExtra("MULTICAST_IFACE");
+            if (multicastGroup != null) {
+                Log.i(TAG, "Multicast group: " + multicastGroup + " (ttl " + multicastTtl + ")");
+            }
+
+            if (intent.hasExtra("ENCODER_PROFILE")) {
+                encoderProfile = intent.getStringExtra("ENCODER_PROFILE");
+                Log.i(TAG, "Encoder profile: " + encoderProfile);
+            }
+
             // IMPORTANT: Start foreground service BEFORE getting MediaProjection
             // Android requires the service to be in foreground mode with MEDIA_PROJECTION type
             if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.UPSIDE_DOWN_CAKE) {
@@ -183,45 +410,38 @@ public class AudioCaptureService extends Service {
                 return;
             }
 
-            java.io.File outputDir = getExternalFilesDir(null);
-            if (outputDir == null) {
-                outputDir = getFilesDir();
+            // The native pipeline records Ogg/Opus off the shared encoder when
+            // given an output path; an empty path disables recording
+            String gstreamerOutputPath = "";
+            if (saveToFile) {
+                java.io.File outputDir = getExternalFilesDir(null);
+                if (outputDir == null) {
+                    outputDir = getFilesDir();
+                }
+                String timestamp = new java.text.SimpleDateFormat("yyyyMMdd_HHmmss", java.util.Locale.US)
+                        .format(new java.util.Date());
+                gstreamerOutputPath = new java.io.File(outputDir, "audio_gstreamer_" + timestamp + ".ogg")
+                        .getAbsolutePath();
+                Log.i(TAG, "Recording audio to: " + gstreamerOutputPath);
+            } else {
+                Log.i(TAG, "File saving disabled - streaming only");
             }
-            String timestamp = new java.text.SimpleDateFormat("yyyyMMdd_HHmmss", java.util.Locale.US)
-                    .format(new java.util.Date());
-            String gstreamerOutputPath = new java.io.File(outputDir, "audio_gstreamer_" + timestamp + ".ogg")
-                    .getAbsolutePath();
 
-            Log.i(TAG, "Initializing GStreamer pipeline with output: " + gstreamerOutputPath);
             Log.i(TAG, "Streaming to host: " + streamHost);
 
-            // Initialize pipeline with 128kbps bitrate for Opus
-            boolean pipelineInitialized = nativeInitPipeline(streamHost,
-                    SAMPLE_RATE,
-                    NUM_CHANNELS,
-                    gstreamerOutputPath,
-                    128000);
-
-            if (!pipelineInitialized) {
-                String error = nativeGetLastError();
-                Log.e(TAG, "Failed to initialize GStreamer pipeline: " + error);
-                Log.w(TAG, "Continuing with Java-only audio recording");
+            captureBufferSize = bufferSize;
+            pipelineOutputPath = gstreamerOutputPath;
+            if (nativeGetPendingStops() > 0) {
+                // Capture starts right away; the pipeline follows once the
+                // previous one has let go of its sockets
+                Log.i(TAG, "Previous GStreamer pipeline still stopping, starting this one when it is gone");
+                pipelineStartPending = true;
+                mainHandler.postDelayed(pendingStartCheck, STOP_DEADLINE_MS);
             } else {
-                // Start the pipeline
-                boolean pipelineStarted = nativeStartPipeline();
-                if (!pipelineStarted) {
-                    String error = nativeGetLastError();
-                    Log.e(TAG, "Failed to start GStreamer pipeline: " + error);
-                    Log.w(TAG, "Continuing with Java-only audio recording");
-                } else {
-                    Log.i(TAG, "GStreamer pipeline started successfully");
-                }
+                startPipeline();
             }
 
-            // Start capture thread
-            captureThread = new Thread(new AudioCaptureRunnable(bufferSize));
-            captureThread.setPriority(Thread.MAX_PRIORITY);
-            captureThread.start();
+            startCaptureThread();
 
         } catch (SecurityException e) {
             Log.e(TAG, "Security exception - missing permissions: " + e.getMessage());
@@ -238,107 +458,177 @@ public class AudioCaptureService extends Service {
         }
     }
 
+    /**
+     * Create and start the main session. Until it exists the capture thread
+     * feeds session 0, which the native side ignores.
+     */
+    private void startPipeline() {
+        // Initialize pipeline with 128kbps bitrate for Opus
+        long created = nativeInitPipeline(streamHost,
+                SAMPLE_RATE,
+                NUM_CHANNELS,
+                AUDIO_FORMAT == AudioFormat.ENCODING_PCM_FLOAT ? "F32LE" : "S16LE",
+                pipelineOutputPath,
+                128000,
+                captureBufferSize,
+                buildPipelineOptions());
+
+        if (created == 0) {
+            String error = nativeGetLastError(0);
+            Log.e(TAG, "Failed to initialize GStreamer pipeline: " + error);
+            Log.w(TAG, "Continuing capture without the GStreamer pipeline");
+            return;
+        }
+
+        Log.i(TAG, "GStreamer pipeline path: " + nativeGetPipelineReport(created));
+        Log.i(TAG, "GStreamer startup: " + GStreamer.getStartupReport());
+
+        // Start the pipeline
+        boolean pipelineStarted = nativeStartPipeline(created);
+        if (!pipelineStarted) {
+            String error = nativeGetLastError(created);
+            Log.e(TAG, "Failed to start GStreamer pipeline: " + error);
+            Log.w(TAG, "Continuing capture without the GStreamer pipeline");
+            stopSession(created);
+            return;
+        }
+
+        session = created;
+        Log.i(TAG, "GStreamer pipeline started successfully");
+        Log.i(TAG, "Receiver pipeline: " + nativeGetReceiverPipeline(created));
+    }
+
+    /**
+     * Stop a session on its native worker; onPipelineStopped reports it gone
+     */
+    private void stopSession(long handle) {
+        nativeStopPipelineAsync(handle, STOP_DEADLINE_MS);
+    }
+
+    /**
+     * Start the pipeline that was waiting for earlier stops once none are
+     * left. Runs after every onPipelineStopped and, in case a stop never
+     * reports back, on a timer until it gets through. While paused the
+     * start waits for resumeAudioCapture().
+     */
+    private void startPendingPipeline() {
+        mainHandler.removeCallbacks(pendingStartCheck);
+        if (!pipelineStartPending || !isCapturing) {
+            return;
+        }
+
+        if (nativeGetPendingStops() > 0) {
+            mainHandler.postDelayed(pendingStartCheck, STOP_DEADLINE_MS);
+            return;
+        }
+
+        pipelineStartPending = false;
+        startPipeline();
+    }
+
+    /**
+     * Native pipeline options, serialized as a GstStructure
+     */
+    private String buildPipelineOptions() {
+        return "options"
+                + ", ring-capacity-ms=(int)" + RING_CAPACITY_MS
+                + ", max-batch-periods=(int)" + (powerSave ? POWER_SAVE_BATCH_PERIODS : 1)
+                + ", backpressure=(string)" + BACKPRESSURE_POLICY
+                + ", encoder-profile=(string)" + encoderProfile
+                + ", abr=(boolean)true"
+                + ", abr-min-bitrate=(int)" + MIN_ADAPTIVE_BITRATE
+                + ", rtx=(boolean)" + retransmission
+                + ", rtx-history-ms=(int)" + RTX_HISTORY_MS
+                + ", egress=(string)" + (batchedEgress ? "batched" : "default")
+                + ", tcp-server=(string)" + tcpServerMode
+                + ", tcp-port=(int)" + TCP_SERVER_PORT
+                + ", tcp-slow-client=(string)" + TCP_SLOW_CLIENT_POLICY
+                + ", rtp-ptime-ms=(int)" + RTP_PTIME_MS
+                + ", mtu=(int)" + RTP_MTU
+                + ", socket-dscp=(int)" + SOCKET_DSCP
+                + ", socket-buffer-size=(int)" + SOCKET_BUFFER_SIZE
+                + ", dont-fragment=(string)" + DONT_FRAGMENT
+                + multicastOptions();
+    }
+
+    private String multicastOptions() {
+        if (multicastGroup == null || multicastGroup.isEmpty()) {
+            return "";
+        }
+
+        String options = ", multicast-group=(string)" + multicastGroup
+                + ", multicast-ttl=(int)" + multicastTtl
+                + ", multicast-loop=(boolean)false";
+        if (multicastInterface != null && !multicastInterface.isEmpty()) {
+            options += ", multicast-iface=(string)" + multicastInterface;
+        }
+        return options;
+    }
+
+    /**
+     * Options for an extra session: its own encoder profile and ports, and
+     * no TCP server or multicast, which stay with the main session
+     */
+    private String buildSessionOptions(String profile, int port) {
+        return "options"
+                + ", ring-capacity-ms=(int)" + RING_CAPACITY_MS
+                + ", max-batch-periods=(int)" + (powerSave ? POWER_SAVE_BATCH_PERIODS : 1)
+                + ", backpressure=(string)" + BACKPRESSURE_POLICY
+                + ", encoder-profile=(string)" + profile
+                + ", abr=(boolean)true"
+                + ", abr-min-bitrate=(int)" + MIN_ADAPTIVE_BITRATE
+                + ", rtp-ptime-ms=(int)" + RTP_PTIME_MS
+                + ", mtu=(int)" + RTP_MTU
+                + ", socket-dscp=(int)" + SOCKET_DSCP
+                + ", socket-buffer-size=(int)" + SOCKET_BUFFER_SIZE
+                + ", dont-fragment=(string)" + DONT_FRAGMENT
+                + ", rtcp-port=(int)" + (port + 1);
+    }
+
+    /**
+     * Start another session on the running capture. It gets a copy of every
+     * period the main session is fed, so both encode the same audio.
+     */
+    private boolean addSession(String host, String profile, int port) {
+        if (session == 0) {
+            return false;
+        }
+
+        long extra = nativeInitPipeline(host,
+                SAMPLE_RATE,
+                NUM_CHANNELS,
+                AUDIO_FORMAT == AudioFormat.ENCODING_PCM_FLOAT ? "F32LE" : "S16LE",
+                "",
+                128000,
+                captureBufferSize,
+                buildSessionOptions(profile, port));
+        if (extra == 0) {
+            Log.e(TAG, "Failed to initialize session: " + nativeGetLastError(0));
+            return false;
+        }
+
+        // Started before it is mirrored, so it is ready for the first period
+        if (!nativeSetPort(extra, port) || !nativeStartPipeline(extra) || !nativeAddMirror(session, extra)) {
+            Log.e(TAG, "Failed to start session: " + nativeGetLastError(extra));
+            stopSession(extra);
+            return false;
+        }
+
+        extraSessions.add(extra);
+        Log.i(TAG, "Session " + extra + " streaming " + profile + " to " + host + ":" + port
+                + ", " + nativeGetSessionCount() + " sessions running");
+        return true;
+    }
+
     private class AudioCaptureRunnable implements Runnable {
         private final int bufferSize;
+        private final int readSize;
         private final ByteBuffer audioBuffer;
-        private final java.io.File outputFile;
-        private java.io.FileOutputStream fileOutputStream;
 
         AudioCaptureRunnable(int bufferSize) {
             this.bufferSize = bufferSize;
-            this.audioBuffer = ByteBuffer.allocateDirect(bufferSize);
-
-            // Create output file only if saving is enabled
-            if (saveToFile) {
-                // Create output file in app's external files directory
-                java.io.File outputDir = getExternalFilesDir(null);
-                if (outputDir == null) {
-                    outputDir = getFilesDir();
-                }
-
-                String timestamp = new java.text.SimpleDateFormat("yyyyMMdd_HHmmss", java.util.Locale.US)
-                        .format(new java.util.Date());
-                this.outputFile = new java.io.File(outputDir, "audio_capture_" + timestamp + ".wav");
-
-                try {
-                    this.fileOutputStream = new java.io.FileOutputStream(outputFile);
-                    writeWavHeader(fileOutputStream, SAMPLE_RATE, NUM_CHANNELS);
-                    Log.i(TAG, "Recording audio to: " + outputFile.getAbsolutePath());
-                } catch (java.io.IOException e) {
-                    Log.e(TAG, "Failed to create output file: " + e.getMessage());
-                    this.fileOutputStream = null;
-                }
-            } else {
-                this.outputFile = null;
-                this.fileOutputStream = null;
-                Log.i(TAG, "File saving disabled - streaming only");
-            }
-        }
-
-        private void writeWavHeader(java.io.FileOutputStream out, int sampleRate, int channels) throws java.io.IOException {
-            byte[] header = new byte[44];
-            int byteRate = sampleRate * channels * 2; // 2 bytes per sample for 16-bit
-
-            // RIFF header
-            header[0] = 'R'; header[1] = 'I'; header[2] = 'F'; header[3] = 'F';
-            // File size (will be updated when closing)
-            header[4] = 0; header[5] = 0; header[6] = 0; header[7] = 0;
-            // WAVE header
-            header[8] = 'W'; header[9] = 'A'; header[10] = 'V'; header[11] = 'E';
-            // fmt chunk
-            header[12] = 'f'; header[13] = 'm'; header[14] = 't'; header[15] = ' ';
-            // fmt chunk size (16 for PCM)
-            header[16] = 16; header[17] = 0; header[18] = 0; header[19] = 0;
-            // Audio format (1 = PCM)
-            header[20] = 1; header[21] = 0;
-            // Number of channels
-            header[22] = (byte) channels; header[23] = 0;
-            // Sample rate
-            header[24] = (byte) (sampleRate & 0xff);
-            header[25] = (byte) ((sampleRate >> 8) & 0xff);
-            header[26] = (byte) ((sampleRate >> 16) & 0xff);
-            header[27] = (byte) ((sampleRate >> 24) & 0xff);
-            // Byte rate
-            header[28] = (byte) (byteRate & 0xff);
-            header[29] = (byte) ((byteRate >> 8) & 0xff);
-            header[30] = (byte) ((byteRate >> 16) & 0xff);
-            header[31] = (byte) ((byteRate >> 24) & 0xff);
-            // Block align
-            header[32] = (byte) (channels * 2); header[33] = 0;
-            // Bits per sample
-            header[34] = 16; header[35] = 0;
-            // data chunk
-            header[36] = 'd'; header[37] = 'a'; header[38] = 't'; header[39] = 'a';
-            // Data size (will be updated when closing)
-            header[40] = 0; header[41] = 0; header[42] = 0; header[43] = 0;
-
-            out.write(header);
-        }
-
-        private void updateWavHeader(java.io.File file) {
-            try {
-                java.io.RandomAccessFile raf = new java.io.RandomAccessFile(file, "rw");
-                long fileSize = raf.length();
-                long dataSize = fileSize - 44; // Subtract WAV header size
-
-                // Update file size in RIFF header (total size - 8)
-                raf.seek(4);
-                raf.write((int) ((fileSize - 8) & 0xff));
-                raf.write((int) (((fileSize - 8) >> 8) & 0xff));
-                raf.write((int) (((fileSize - 8) >> 16) & 0xff));
-                raf.write((int) (((fileSize - 8) >> 24) & 0xff));
-
-                // Update data size in data chunk
-                raf.seek(40);
-                raf.write((int) (dataSize & 0xff));
-                raf.write((int) ((dataSize >> 8) & 0xff));
-                raf.write((int) ((dataSize >> 16) & 0xff));
-                raf.write((int) ((dataSize >> 24) & 0xff));
-
-                raf.close();
-            } catch (java.io.IOException e) {
-                Log.e(TAG, "Error updating WAV header: " + e.getMessage());
-            }
+            this.readSize = powerSave ? bufferSize * POWER_SAVE_BATCH_PERIODS : bufferSize;
+            this.audioBuffer = ByteBuffer.allocateDirect(readSize);
         }
 
         @Override
@@ -347,68 +637,38 @@ public class AudioCaptureService extends Service {
                     android.os.Process.THREAD_PRIORITY_URGENT_AUDIO
             );
 
-            byte[] buffer = new byte[bufferSize];
-
+            // PCM16 and float capture share one path: AudioRecord writes either
+            // format into a direct buffer, so nothing is allocated per period
             while (isCapturing) {
                 int dataSize = 0;
+                long current = session;
 
-                if (AUDIO_FORMAT == AudioFormat.ENCODING_PCM_FLOAT) {
-                    // For float audio
-                    float[] floatBuffer = new float[bufferSize / 4];
-                    int readFloats = audioRecord.read(
-                            floatBuffer, 0,
-                            floatBuffer.length,
-                            AudioRecord.READ_BLOCKING
-                    );
-
-                    if (readFloats > 0) {
-                        // Convert float to bytes for JNI transfer
-                        audioBuffer.clear();
-                        audioBuffer.asFloatBuffer().put(floatBuffer, 0, readFloats);
-                        audioBuffer.position(0);
-                        audioBuffer.get(buffer, 0, readFloats * 4);
-                        dataSize = readFloats * 4;
-
-                        // Write audio data to file (Java - for testing/debugging)
-                        if (fileOutputStream != null) {
-                            try {
-                                fileOutputStream.write(buffer, 0, dataSize);
-                            } catch (java.io.IOException e) {
-                                Log.e(TAG, "Error writing audio data: " + e.getMessage());
-                            }
-                        }
-
-                        // Feed audio data to GStreamer pipeline
-                        if (!nativeFeedAudioData(buffer, dataSize)) {
-                            String error = nativeGetLastError();
-                            Log.w(TAG, "Failed to feed audio data to GStreamer: " + error);
-                        }
-                    }
-                } else {
-                    // For PCM16 audio
-                    int bytesRead = audioRecord.read(
-                            buffer, 0,
-                            buffer.length,
-                            AudioRecord.READ_BLOCKING
-                    );
-
-                    if (bytesRead > 0) {
-                        dataSize = bytesRead;
-
-                        if (fileOutputStream != null && saveToFile) {
-                            try {
-                                fileOutputStream.write(buffer, 0, dataSize);
-                            } catch (java.io.IOException e) {
-                                Log.e(TAG, "Error writing audio data: " + e.getMessage());
-                            }
-                        }
-
-                        // Feed audio data to GStreamer pipeline
-                        if (!nativeFeedAudioData(buffer, dataSize)) {
-                            String error = nativeGetLastError();
-                            Log.w(TAG, "Failed to feed audio data to GStreamer: " + error);
-                        }
-                    }
+                // Read straight into a native slab when one is free so the data
+                // reaches appsrc without being copied
+                ByteBuffer readBuffer = nativeAcquireDirectBuffer(current);
+                if (readBuffer == null) {
+                    readBuffer = audioBuffer;
+                }
+                readBuffer.clear();
+
+                int bytesRead = audioRecord.read(
+                        readBuffer,
+                        readSize,
+                        AudioRecord.READ_BLOCKING
+                );
+
+                if (bytesRead > 0) {
+                    dataSize = bytesRead;
+                }
+
+                // Feed audio data to GStreamer pipeline (an empty read hands a
+                // native slab back to its pool)
+                boolean fed = powerSave
+                        ? nativeFeedDirectBatch(current, readBuffer, dataSize, bufferSize)
+                        : nativeFeedDirectBuffer(current, readBuffer, dataSize);
+                if (!fed) {
+                    String error = nativeGetLastError(current);
+                    Log.w(TAG, "Failed to feed audio data to GStreamer: " + error);
                 }
 
                 if (audioRecord.getRecordingState() != AudioRecord.RECORDSTATE_RECORDING) {
@@ -416,43 +676,97 @@ public class AudioCaptureService extends Service {
                     break;
                 }
             }
+        }
+    }
 
-            // Close file and update WAV header (only if saving to file)
-            if (saveToFile && fileOutputStream != null) {
-                try {
-                    fileOutputStream.close();
-                    // Update WAV header with correct file size
-                    updateWavHeader(outputFile);
-                    Log.d(TAG, "Audio capture finished. File: " + outputFile.getAbsolutePath() +
-                          ", Size: " + outputFile.length() + " bytes");
-                } catch (java.io.IOException e) {
-                    Log.e(TAG, "Error closing output file: " + e.getMessage());
-                }
+    private void startCaptureThread() {
+        captureThread = new Thread(new AudioCaptureRunnable(captureBufferSize));
+        captureThread.setPriority(Thread.MAX_PRIORITY);
+        captureThread.start();
+    }
+
+    /**
+     * Stop capturing but keep AudioRecord and the prerolled pipeline, so
+     * resumeAudioCapture() is back on air within milliseconds
+     */
+    private void pauseAudioCapture() {
+        if (!isCapturing || audioRecord == null) {
+            return;
+        }
+
+        isCapturing = false;
+        try {
+            audioRecord.stop();
+        } catch (Exception e) {
+            Log.e(TAG, "Error stopping audio record: " + e.getMessage());
+        }
+
+        // The capture thread must be out of the native feed calls first
+        if (captureThread != null) {
+            try {
+                captureThread.join(1000);
+            } catch (InterruptedException e) {
+                Log.e(TAG, "Thread join interrupted");
             }
+            captureThread = null;
+        }
+
+        if (!nativePause(session)) {
+            Log.w(TAG, "Failed to pause GStreamer pipeline: " + nativeGetLastError(session));
         }
+        for (long extra : extraSessions) {
+            nativePause(extra);
+        }
+        isPaused = true;
+        Log.i(TAG, "Audio capture paused, pipeline in standby");
     }
 
-    private void stopAudioCapture() {
-        isCapturing = false;
+    private void resumeAudioCapture() {
+        if (!isPaused || audioRecord == null) {
+            return;
+        }
+
+        long started = System.nanoTime();
+        // A pipeline left in PAUSED would only fill its ring until it
+        // overruns, so don't restart capture on top of it
+        if (session != 0 && !nativeResume(session)) {
+            Log.w(TAG, "Failed to resume GStreamer pipeline, staying paused: " + nativeGetLastError(session));
+            return;
+        }
+        for (long extra : extraSessions) {
+            nativeResume(extra);
+        }
 
-        // Stop GStreamer pipeline first
         try {
-            Log.i(TAG, "Stopping GStreamer pipeline");
-            nativeStopPipeline();
-        } catch (Exception e) {
-            Log.e(TAG, "Error stopping GStreamer pipeline: " + e.getMessage());
+            audioRecord.startRecording();
+        } catch (IllegalStateException e) {
+            Log.e(TAG, "Failed to restart recording: " + e.getMessage());
+            return;
         }
 
+        isPaused = false;
+        isCapturing = true;
+        startPendingPipeline();
+        startCaptureThread();
+        Log.i(TAG, "Audio capture resumed in " + (System.nanoTime() - started) / 1000 + " us");
+    }
+
+    private void stopAudioCapture() {
+        isCapturing = false;
+        isPaused = false;
+        pipelineStartPending = false;
+        mainHandler.removeCallbacks(pendingStartCheck);
+
         if (audioRecord != null) {
             try {
                 audioRecord.stop();
-                audioRecord.release();
             } catch (Exception e) {
                 Log.e(TAG, "Error stopping audio record: " + e.getMessage());
             }
-            audioRecord = null;
         }
 
+        // The capture thread may hold a native slab, so it must finish before
+        // the pipeline (and its slab pool) is torn down
         if (captureThread != null) {
             try {
                 captureThread.join(1000);
@@ -461,6 +775,161 @@ public class AudioCaptureService extends Service {
             }
             captureThread = null;
         }
+
+        if (audioRecord != null) {
+            try {
+                audioRecord.release();
+            } catch (Exception e) {
+                Log.e(TAG, "Error releasing audio record: " + e.getMessage());
+            }
+            audioRecord = null;
+        }
+
+        // Stop GStreamer pipeline. It drains on a native worker and reports
+        // back through onPipelineStopped, so this never blocks the caller
+        try {
+            logPipelineStats();
+            Log.i(TAG, "Stopping GStreamer pipeline");
+            for (long extra : extraSessions) {
+                stopSession(extra);
+            }
+            extraSessions.clear();
+            if (session != 0) {
+                stopSession(session);
+                session = 0;
+            }
+        } catch (Exception e) {
+            Log.e(TAG, "Error stopping GStreamer pipeline: " + e.getMessage());
+        }
+    }
+
+    /**
+     * Bus events from the native bus thread, batched. Runs on that thread,
+     * so anything touching the pipeline is posted to the main thread.
+     */
+    @SuppressWarnings("unused")
+    private void onPipelineEvents(long eventSession, int[] types, String[] messages) {
+        boolean failed = false;
+        for (int i = 0; i < types.length; i++) {
+            switch (types[i]) {
+                case EVENT_ERROR:
+                    Log.e(TAG, "Pipeline error: " + messages[i]);
+                    failed = true;
+                    break;
+                case EVENT_WARNING:
+                    Log.w(TAG, "Pipeline warning: " + messages[i]);
+                    break;
+                case EVENT_QOS:
+                    Log.d(TAG, "Pipeline QoS: " + messages[i]);
+                    break;
+                case EVENT_DROPPED:
+                    Log.w(TAG, "Pipeline events lost: " + messages[i]);
+                    break;
+                default:
+                    Log.i(TAG, "Pipeline event: " + messages[i]);
+                    break;
+            }
+        }
+
+        // A pipeline that posted an error has stopped streaming. Tear its
+        // session down so the sockets are released, and keep capturing: an
+        // extra session takes over from a failed main one, otherwise it is
+        // as after a failed init
+        if (failed) {
+            mainHandler.post(() -> {
+                if (eventSession != session && !extraSessions.contains(eventSession)) {
+                    return;
+                }
+
+                Log.w(TAG, "Stopping failed session " + eventSession + ": " + nativeGetLastError(eventSession));
+                stopSession(eventSession);
+                if (eventSession == session) {
+                    promoteExtraSession();
+                } else {
+                    extraSessions.remove(eventSession);
+                }
+            });
+        }
+    }
+
+    /**
+     * The main session is gone and its extra sessions no longer get audio:
+     * the first one is fed by the capture thread from now on and the others
+     * mirror it
+     */
+    private void promoteExtraSession() {
+        if (extraSessions.isEmpty()) {
+            session = 0;
+            return;
+        }
+
+        long promoted = extraSessions.remove(0);
+        session = promoted;
+        for (Iterator<Long> it = extraSessions.iterator(); it.hasNext(); ) {
+            long extra = it.next();
+            if (!nativeAddMirror(promoted, extra)) {
+                Log.w(TAG, "Session " + extra + " can't follow session " + promoted + ": "
+                        + nativeGetLastError(promoted));
+                stopSession(extra);
+                it.remove();
+            }
+        }
+        Log.i(TAG, "Session " + promoted + " took over the capture, "
+                + extraSessions.size() + " sessions mirror it");
+    }
+
+    /**
+     * Called from the native stop worker once the pipeline is gone. A start
+     * that was waiting for the stops to finish goes ahead from here.
+     */
+    @SuppressWarnings("unused")
+    private void onPipelineStopped(long stoppedSession, boolean drained, long elapsedMicros) {
+        Log.i(TAG, "GStreamer session " + stoppedSession + " stopped in " + (elapsedMicros / 1000.0) + " ms"
+                + (drained ? "" : " (deadline hit, forced to NULL)"));
+
+        mainHandler.post(this::startPendingPipeline);
+    }
+
+    private void logPipelineStats() {
+        long[] stats = nativeGetStats(session);
+        if (stats == null) {
+            return;
+        }
+
+        Log.i(TAG, "Pipeline stats: pool " + stats[STAT_POOL_HITS] + " hits / "
+                + stats[STAT_POOL_MISSES] + " misses (grew " + stats[STAT_POOL_GROWTH] + "), ring "
+                + stats[STAT_RING_OVERRUNS] + " overruns / " + stats[STAT_RING_UNDERRUNS] + " underruns, "
+                + stats[STAT_DISCONTINUITIES] + " discontinuities");
+        Log.i(TAG, "Audio dropped: " + stats[STAT_DROPPED_BUFFERS] + " buffers, "
+                + stats[STAT_DROPPED_SAMPLES] + " samples, "
+                + (stats[STAT_DROPPED_DURATION_NS] / 1000000) + " ms");
+        Log.i(TAG, "Network: encoder at " + stats[STAT_ENCODER_BITRATE] + " bps, receiver reports "
+                + (stats[STAT_RTCP_FRACTION_LOST] * 100 / 256) + "% loss, "
+                + (stats[STAT_RTCP_JITTER_US] / 1000) + " ms jitter");
+        if (stats[STAT_TIME_TO_FIRST_PACKET_US] >= 0) {
+            Log.i(TAG, "Time to first packet after last start/resume: "
+                    + (stats[STAT_TIME_TO_FIRST_PACKET_US] / 1000.0) + " ms");
+        }
+        Log.i(TAG, "Startup: create " + (stats[STAT_INIT_CREATE_US] / 1000.0) + " ms, link "
+                + (stats[STAT_INIT_LINK_US] / 1000.0) + " ms, configure "
+                + (stats[STAT_INIT_CONFIGURE_US] / 1000.0) + " ms, start "
+                + (stats[STAT_START_US] / 1000.0) + " ms, cold start to first packet "
+                + (stats[STAT_COLD_START_US] >= 0 ? (stats[STAT_COLD_START_US] / 1000.0) + " ms" : "pending"));
+        Log.i(TAG, "Packetization: " + stats[STAT_RTP_PACKET_RATE] + " packets/s, "
+                + (stats[STAT_RTP_OVERHEAD_PERMILLE] / 10.0) + "% header overhead");
+        Log.i(TAG, "Retransmission: " + stats[STAT_NACKS_RECEIVED] + " NACKs, "
+                + stats[STAT_RTX_PACKETS] + " packets resent, "
+                + stats[STAT_RTX_HISTORY_MISSES] + " history misses");
+        if (batchedEgress) {
+            Log.i(TAG, "Egress: " + stats[STAT_EGRESS_SYSCALLS] + " send syscalls, "
+                    + stats[STAT_EGRESS_SYSCALLS_PER_SECOND] + "/s, dropped "
+                    + stats[STAT_SEND_EAGAIN] + " on EAGAIN, "
+                    + stats[STAT_SEND_ENOBUFS] + " on ENOBUFS");
+        }
+        if (!"none".equals(tcpServerMode)) {
+            Log.i(TAG, "TCP server: " + stats[STAT_TCP_CLIENTS] + " clients, max lag "
+                    + stats[STAT_TCP_MAX_LAG_MS] + " ms\n" + nativeGetClientReport(session));
+        }
     }
 
     private void createNotificationChannel() {
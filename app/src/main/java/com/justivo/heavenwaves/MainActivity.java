@@ -46,6 +46,10 @@ public class MainActivity extends AppCompatActivity {
     private TextView statusText;
     private android.widget.EditText hostInput;
     private android.widget.CheckBox saveToFile;
+    // The service stays up while paused, keeping its projection and a warm
+    // pipeline, so only a stop from the paused state tears it down
+    private boolean serviceRunning = false;
+    private boolean isPaused = false;
 
     @SuppressLint("InlinedApi")
     private final String[] permissionsToRequest = {
@@ -91,6 +95,8 @@ public class MainActivity extends AppCompatActivity {
                     serviceIntent.putExtra("SAVE_TO_FILE", saveToFile.isChecked());
                     startForegroundService(serviceIntent);
 
+                    serviceRunning = true;
+                    isPaused = false;
                     updateUIState(true);
                     Toast.makeText(this, "Audio capture started", Toast.LENGTH_SHORT).show();
                 } else {
@@ -138,8 +144,20 @@ public class MainActivity extends AppCompatActivity {
         saveToFile = findViewById(R.id.save_to_file_checkbox);
 
         // Set up button listeners
-        startButton.setOnClickListener(v -> requestMediaProjection());
-        stopButton.setOnClickListener(v -> stopAudioCapture());
+        startButton.setOnClickListener(v -> {
+            if (serviceRunning) {
+                resumeAudioCapture();
+            } else {
+                requestMediaProjection();
+            }
+        });
+        stopButton.setOnClickListener(v -> {
+            if (isPaused) {
+                stopAudioCapture();
+            } else {
+                pauseAudioCapture();
+            }
+        });
 
         // Request necessary permissions on startup
         permissionsLauncher.launch(permissionsToRequest);
@@ -175,7 +193,7 @@ public class MainActivity extends AppCompatActivity {
                 .onDismiss(permissionDialogQueue::removeFirst)
                 .onContinue(() -> {
                     permissionsLauncher.launch(new String[] { permission });
-                    updateUIState(false);
+                    updateUIState(serviceRunning && !isPaused);
                 })
                 .onGoToAppSettingsClick(this::openAppSettings)
                 .build();
@@ -188,20 +206,46 @@ public class MainActivity extends AppCompatActivity {
         mediaProjectionLauncher.launch(intent);
     }
 
+    private void pauseAudioCapture() {
+        sendServiceAction("AudioCaptureService:Pause");
+
+        isPaused = true;
+        updateUIState(false);
+        Toast.makeText(this, "Audio capture paused", Toast.LENGTH_SHORT).show();
+    }
+
+    private void resumeAudioCapture() {
+        sendServiceAction("AudioCaptureService:Resume");
+
+        isPaused = false;
+        updateUIState(true);
+        Toast.makeText(this, "Audio capture resumed", Toast.LENGTH_SHORT).show();
+    }
+
     private void stopAudioCapture() {
-        Intent serviceIntent = new Intent(this, AudioCaptureService.class);
-        serviceIntent.setAction("AudioCaptureService:Stop");
-        startService(serviceIntent);
+        sendServiceAction("AudioCaptureService:Stop");
 
+        serviceRunning = false;
+        isPaused = false;
         updateUIState(false);
         Toast.makeText(this, "Audio capture stopped", Toast.LENGTH_SHORT).show();
     }
 
+    private void sendServiceAction(String action) {
+        Intent serviceIntent = new Intent(this, AudioCaptureService.class);
+        serviceIntent.setAction(action);
+        startService(serviceIntent);
+    }
+
     private void updateUIState(boolean isRecording) {
         startButton.setEnabled(!isRecording);
-        stopButton.setEnabled(isRecording);
-        saveToFile.setEnabled(!isRecording);
-        statusText.setText(isRecording ? "Recording..." : "Not recording");
+        startButton.setText(isPaused ? "Resume Audio Capture" : "Start Audio Capture");
+        stopButton.setEnabled(serviceRunning);
+        stopButton.setText(isRecording ? "Pause Audio Capture" : "Stop Audio Capture");
+        // Host and file output only take effect on a fresh start
+        hostInput.setEnabled(!serviceRunning);
+        saveToFile.setEnabled(!serviceRunning);
+        statusText.setText(isRecording ? "Recording..." : isPaused ? "Paused" : "Not recording");
     }
 
     private void openAppSettings() {
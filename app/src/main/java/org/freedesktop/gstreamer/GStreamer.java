@@ -1,7 +1,6 @@
 /**
- * Copy this file into your Android project and call init(). If your project
- * contains fonts and/or certificates in assets, uncomment copyFonts() and/or
- * copyCaCertificates() lines in init().
+ * Copy this file into your Android project and call init(). Fonts and
+ * certificates are only copied from assets in STARTUP_FULL mode.
  */
 package org.freedesktop.gstreamer;
 
@@ -16,13 +15,51 @@ import android.content.res.AssetManager;
 import android.system.Os;
 
 public class GStreamer {
-    private static native void nativeInit(Context context) throws Exception;
+    // Startup modes: FULL keeps stock behaviour, SELECTIVE skips registry
+    // rescans and the asset copies and preloads only the streaming plugins
+    public static final int STARTUP_FULL = 0;
+    public static final int STARTUP_SELECTIVE = 1;
+
+    // Indices into nativeGetStartupTimings(); times in microseconds, -1 until known
+    public static final int STARTUP_REGISTRY_US = 0;
+    public static final int STARTUP_PLUGINS_US = 1;
+    public static final int STARTUP_FIRST_PIPELINE_US = 2;
+    public static final int STARTUP_PLUGIN_COUNT = 3;
+
+    private static native void nativeInit(Context context, boolean selective) throws Exception;
     public static native String nativeGetGStreamerInfo();
+    public static native long[] nativeGetStartupTimings();
+
+    private static long assetCopyMicros = -1;
 
     public static void init(Context context) throws Exception {
-        copyFonts(context);
-        copyCaCertificates(context);
-        nativeInit(context);
+        init(context, STARTUP_SELECTIVE);
+    }
+
+    public static void init(Context context, int mode) throws Exception {
+        if (mode == STARTUP_FULL) {
+            long start = System.nanoTime();
+            copyFonts(context);
+            copyCaCertificates(context);
+            assetCopyMicros = (System.nanoTime() - start) / 1000;
+        }
+        nativeInit(context, mode == STARTUP_SELECTIVE);
+    }
+
+    /**
+     * Startup breakdown for logging
+     */
+    public static String getStartupReport() {
+        long[] timings = nativeGetStartupTimings();
+        return "registry " + formatMicros(timings[STARTUP_REGISTRY_US])
+                + ", plugins " + formatMicros(timings[STARTUP_PLUGINS_US])
+                + ", first pipeline " + formatMicros(timings[STARTUP_FIRST_PIPELINE_US])
+                + ", assets " + formatMicros(assetCopyMicros)
+                + ", " + timings[STARTUP_PLUGIN_COUNT] + " plugins registered";
+    }
+
+    private static String formatMicros(long micros) {
+        return micros < 0 ? "n/a" : (micros / 1000.0) + " ms";
     }
 
     private static void copyFonts(Context context) {
@@ -3,7 +3,7 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE    := audio_bridge
-LOCAL_SRC_FILES := native-audio-bridge.cpp gstreamer-info.cpp
+LOCAL_SRC_FILES := native-audio-bridge.cpp gstreamer-info.cpp batched-udp-sink.cpp opus-aggregator.cpp
 LOCAL_SHARED_LIBRARIES := gstreamer_android
 LOCAL_LDLIBS := -llog
 
@@ -37,9 +37,10 @@ endif
 GSTREAMER_NDK_BUILD_PATH  := $(GSTREAMER_ROOT)/share/gst-android/ndk-build/
 
 include $(GSTREAMER_NDK_BUILD_PATH)/plugins.mk
-GSTREAMER_PLUGINS         := $(GSTREAMER_PLUGINS_CORE) $(GSTREAMER_PLUGINS_SYS) $(GSTREAMER_PLUGINS_CODECS) $(GSTREAMER_PLUGINS_NET)
-GSTREAMER_PLUGINS_CODECS  := opus ogg
-GSTREAMER_EXTRA_DEPS      := gstreamer-1.0 gstreamer-app-1.0
+# Only the plugins the pipelines use: every linked-in plugin is registered
+# by gst_init on each launch
+GSTREAMER_PLUGINS         := coreelements app audioconvert audioresample opus ogg rtp rtpmanager udp tcp
+GSTREAMER_EXTRA_DEPS      := gstreamer-1.0 gstreamer-base-1.0 gstreamer-app-1.0 gstreamer-rtp-1.0 opus
 GSTREAMER_EXTRA_LIBS      := -liconv
 
 include $(GSTREAMER_NDK_BUILD_PATH)/gstreamer-1.0.mk
\ No newline at end of file
@@ -0,0 +1,795 @@
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <android/log.h>
+#include <gst/gst.h>
+#include <gst/base/gstbasesink.h>
+
+#define LOG_TAG "BatchedUdpSink"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+// UDP generic segmentation offload, Linux 4.18+; older NDK headers lack it
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+// Packets x destinations held before a send is forced
+#define DEFAULT_MAX_BATCH 32
+
+// Longest a packet may wait for the rest of its batch
+#define DEFAULT_MAX_LATENCY (2 * GST_MSECOND)
+
+// -1 leaves the kernel default for buffer-size, qos-dscp and dont-fragment
+#define SOCKET_OPTION_DEFAULT -1
+
+// Kernel limits for one GSO send
+#define MAX_GSO_SEGMENTS 64
+#define MAX_GSO_BYTES 65000
+
+/**
+ * One receiver, resolved once when it is added
+ */
+struct BatchDestination {
+    std::string host;
+    gint port;
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+};
+
+/**
+ * Packet waiting for the next batch, mapped for the whole wait
+ */
+struct PendingPacket {
+    GstBuffer *buffer;
+    GstMapInfo map;
+};
+
+/**
+ * C++ side of the element, kept out of the GObject instance struct
+ *
+ * The message, iovec and control arrays are scratch space reused by every
+ * flush, so steady-state sending doesn't allocate.
+ */
+struct BatchState {
+    std::vector<BatchDestination> destinations;
+    std::vector<PendingPacket> pending;
+    gint64 first_pending_us = 0;
+
+    std::vector<struct mmsghdr> messages;
+    std::vector<struct iovec> iovecs;
+    std::vector<guint8> controls;
+};
+
+/**
+ * BatchedUdpSink - multiudpsink replacement that batches its syscalls
+ *
+ * Packets are held until max-batch packet copies are queued or the oldest
+ * has waited max-latency, then sent to every destination with a single
+ * sendmmsg per address family. Where the kernel supports UDP GSO, runs of
+ * same-sized packets to one destination also collapse into one message.
+ * Exposes the same add/remove/clear action signals as multiudpsink.
+ */
+struct BatchedUdpSink {
+    GstBaseSink parent;
+
+    GMutex lock;
+    GCond cond;
+    BatchState *state;
+
+    gint socket_v4;
+    gint socket_v6;
+    gboolean gso_supported;
+
+    GThread *flusher;
+    gboolean flusher_stop;
+
+    guint max_batch;
+    guint64 max_latency;
+    gboolean gso;
+    gint buffer_size;
+    gint qos_dscp;
+    gint dont_fragment;
+
+    guint64 syscalls;
+    guint64 packets_sent;
+    guint64 send_errors;
+    guint64 send_eagain;
+    guint64 send_enobufs;
+    gint64 window_start_us;
+    guint64 window_syscalls;
+    gdouble syscalls_per_second;
+};
+
+struct BatchedUdpSinkClass {
+    GstBaseSinkClass parent_class;
+
+    void (*add)(BatchedUdpSink *sink, const gchar *host, gint port);
+    void (*remove)(BatchedUdpSink *sink, const gchar *host, gint port);
+    void (*clear)(BatchedUdpSink *sink);
+};
+
+enum {
+    PROP_0,
+    PROP_CLIENTS,
+    PROP_MAX_BATCH,
+    PROP_MAX_LATENCY,
+    PROP_GSO,
+    PROP_SYSCALLS,
+    PROP_PACKETS_SENT,
+    PROP_SEND_ERRORS,
+    PROP_SYSCALLS_PER_SECOND,
+    PROP_BUFFER_SIZE,
+    PROP_QOS_DSCP,
+    PROP_DONT_FRAGMENT,
+    PROP_SEND_EAGAIN,
+    PROP_SEND_ENOBUFS,
+};
+
+enum {
+    SIGNAL_ADD,
+    SIGNAL_REMOVE,
+    SIGNAL_CLEAR,
+    LAST_SIGNAL
+};
+
+static guint batched_udp_sink_signals[LAST_SIGNAL] = { 0 };
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+G_DEFINE_TYPE(BatchedUdpSink, batched_udp_sink, GST_TYPE_BASE_SINK)
+
+#define BATCHED_UDP_SINK(obj) (reinterpret_cast<BatchedUdpSink*>(obj))
+
+static void release_pending_locked(BatchedUdpSink *sink) {
+    for (PendingPacket &packet : sink->state->pending) {
+        gst_buffer_unmap(packet.buffer, &packet.map);
+        gst_buffer_unref(packet.buffer);
+    }
+    sink->state->pending.clear();
+}
+
+static gint socket_for_locked(BatchedUdpSink *sink, const BatchDestination &destination) {
+    return destination.addr.ss_family == AF_INET6 ? sink->socket_v6 : sink->socket_v4;
+}
+
+/**
+ * Send count messages on one socket, in as few syscalls as the kernel allows
+ */
+static void send_messages_locked(BatchedUdpSink *sink, gint fd, struct mmsghdr *messages, guint count) {
+    guint sent = 0;
+
+    while (sent < count) {
+        // Never block the streaming thread on a full send buffer; the
+        // EAGAIN/ENOBUFS counts show when that happens
+        gint result = sendmmsg(fd, messages + sent, count - sent, MSG_DONTWAIT);
+        sink->syscalls++;
+        sink->window_syscalls++;
+
+        if (result < 0) {
+            gint error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+
+            sink->send_errors++;
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                sink->send_eagain++;
+            } else if (error == ENOBUFS) {
+                sink->send_enobufs++;
+            } else if ((error == EIO || error == EINVAL) && sink->gso_supported) {
+                // Device can't segment; later batches go out one packet per message
+                LOGW("UDP GSO send failed (%s), disabling GSO", strerror(error));
+                sink->gso_supported = FALSE;
+            }
+
+            // Dropping the failed message is what udpsink does too
+            sent++;
+            continue;
+        }
+
+        sent += result;
+    }
+}
+
+/**
+ * Send everything pending to every destination
+ */
+static void flush_locked(BatchedUdpSink *sink) {
+    BatchState *state = sink->state;
+    guint packet_count = state->pending.size();
+
+    if (packet_count == 0) {
+        return;
+    }
+
+    guint destination_count = state->destinations.size();
+    guint max_messages = packet_count * destination_count;
+    bool use_gso = sink->gso && sink->gso_supported;
+
+    if (state->messages.size() < max_messages) {
+        state->messages.resize(max_messages);
+        state->iovecs.resize(max_messages);
+        state->controls.resize(max_messages * CMSG_SPACE(sizeof(guint16)));
+    }
+
+    // IPv4 destinations first, then IPv6, so each family is one contiguous
+    // sendmmsg run
+    guint message_count = 0, v4_count = 0;
+    guint iovec_index = 0;
+
+    for (gint family : { AF_INET, AF_INET6 }) {
+        for (BatchDestination &destination : state->destinations) {
+            if (destination.addr.ss_family != family || socket_for_locked(sink, destination) < 0) {
+                continue;
+            }
+
+            guint i = 0;
+            while (i < packet_count) {
+                guint j = i + 1;
+                gsize segment_size = state->pending[i].map.size;
+                gsize total = segment_size;
+
+                if (use_gso) {
+                    // Equal-sized segments, only the last one may be shorter
+                    while (j < packet_count && j - i < MAX_GSO_SEGMENTS &&
+                           state->pending[j].map.size <= segment_size &&
+                           total + state->pending[j].map.size <= MAX_GSO_BYTES) {
+                        total += state->pending[j].map.size;
+                        bool shorter = state->pending[j].map.size < segment_size;
+                        j++;
+                        if (shorter) {
+                            break;
+                        }
+                    }
+                }
+
+                guint slot = message_count++;
+                struct mmsghdr &message = state->messages[slot];
+                memset(&message, 0, sizeof(message));
+
+                message.msg_hdr.msg_name = &destination.addr;
+                message.msg_hdr.msg_namelen = destination.addr_len;
+                message.msg_hdr.msg_iov = &state->iovecs[iovec_index];
+                message.msg_hdr.msg_iovlen = j - i;
+
+                for (guint k = i; k < j; k++) {
+                    state->iovecs[iovec_index].iov_base = state->pending[k].map.data;
+                    state->iovecs[iovec_index].iov_len = state->pending[k].map.size;
+                    iovec_index++;
+                }
+
+                if (j - i > 1) {
+                    guint8 *control = &state->controls[slot * CMSG_SPACE(sizeof(guint16))];
+                    memset(control, 0, CMSG_SPACE(sizeof(guint16)));
+                    message.msg_hdr.msg_control = control;
+                    message.msg_hdr.msg_controllen = CMSG_SPACE(sizeof(guint16));
+
+                    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message.msg_hdr);
+                    cmsg->cmsg_level = SOL_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN(sizeof(guint16));
+                    guint16 gso_size = (guint16) segment_size;
+                    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(gso_size));
+                }
+
+                i = j;
+            }
+        }
+
+        if (family == AF_INET) {
+            v4_count = message_count;
+        }
+    }
+
+    if (v4_count > 0) {
+        send_messages_locked(sink, sink->socket_v4, state->messages.data(), v4_count);
+    }
+    if (message_count > v4_count) {
+        send_messages_locked(sink, sink->socket_v6, state->messages.data() + v4_count, message_count - v4_count);
+    }
+
+    sink->packets_sent += (guint64) packet_count * destination_count;
+    release_pending_locked(sink);
+
+    gint64 now = g_get_monotonic_time();
+    if (now - sink->window_start_us >= G_USEC_PER_SEC) {
+        sink->syscalls_per_second = sink->window_syscalls * (gdouble) G_USEC_PER_SEC / (now - sink->window_start_us);
+        sink->window_syscalls = 0;
+        sink->window_start_us = now;
+    }
+}
+
+/**
+ * Sends a partial batch once its oldest packet reaches max-latency
+ */
+static gpointer flusher_loop(gpointer data) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(data);
+
+    g_mutex_lock(&sink->lock);
+    while (!sink->flusher_stop) {
+        if (sink->state->pending.empty()) {
+            g_cond_wait(&sink->cond, &sink->lock);
+            continue;
+        }
+
+        gint64 deadline = sink->state->first_pending_us + (gint64) (sink->max_latency / GST_USECOND);
+        if (g_get_monotonic_time() >= deadline) {
+            flush_locked(sink);
+        } else {
+            g_cond_wait_until(&sink->cond, &sink->lock, deadline);
+        }
+    }
+    g_mutex_unlock(&sink->lock);
+
+    return nullptr;
+}
+
+static void queue_buffer_locked(BatchedUdpSink *sink, GstBuffer *buffer) {
+    PendingPacket packet;
+    packet.buffer = gst_buffer_ref(buffer);
+    if (!gst_buffer_map(packet.buffer, &packet.map, GST_MAP_READ)) {
+        gst_buffer_unref(packet.buffer);
+        return;
+    }
+
+    if (sink->state->pending.empty()) {
+        sink->state->first_pending_us = g_get_monotonic_time();
+        g_cond_signal(&sink->cond);
+    }
+    sink->state->pending.push_back(packet);
+}
+
+static void flush_if_full_locked(BatchedUdpSink *sink) {
+    guint copies = sink->state->pending.size() * MAX(sink->state->destinations.size(), (gsize) 1);
+    if (sink->state->destinations.empty()) {
+        release_pending_locked(sink);
+    } else if (copies >= sink->max_batch || sink->max_latency == 0) {
+        flush_locked(sink);
+    }
+}
+
+static GstFlowReturn batched_udp_sink_render(GstBaseSink *basesink, GstBuffer *buffer) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(basesink);
+
+    g_mutex_lock(&sink->lock);
+    queue_buffer_locked(sink, buffer);
+    flush_if_full_locked(sink);
+    g_mutex_unlock(&sink->lock);
+
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn batched_udp_sink_render_list(GstBaseSink *basesink, GstBufferList *list) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(basesink);
+
+    g_mutex_lock(&sink->lock);
+    for (guint i = 0; i < gst_buffer_list_length(list); i++) {
+        queue_buffer_locked(sink, gst_buffer_list_get(list, i));
+    }
+    flush_if_full_locked(sink);
+    g_mutex_unlock(&sink->lock);
+
+    return GST_FLOW_OK;
+}
+
+static gboolean batched_udp_sink_event(GstBaseSink *basesink, GstEvent *event) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(basesink);
+
+    if (GST_EVENT_TYPE(event) == GST_EVENT_EOS) {
+        g_mutex_lock(&sink->lock);
+        flush_locked(sink);
+        g_mutex_unlock(&sink->lock);
+    }
+
+    return GST_BASE_SINK_CLASS(batched_udp_sink_parent_class)->event(basesink, event);
+}
+
+/**
+ * Apply buffer-size, qos-dscp and dont-fragment to a freshly created socket
+ */
+static void configure_socket(BatchedUdpSink *sink, gint fd, gint family) {
+    if (fd < 0) {
+        return;
+    }
+
+    if (sink->buffer_size > 0 &&
+        setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sink->buffer_size, sizeof(sink->buffer_size)) < 0) {
+        LOGW("Could not set send buffer to %d bytes: %s", sink->buffer_size, strerror(errno));
+    }
+
+    if (sink->qos_dscp >= 0) {
+        // DSCP is the top six bits of the TOS / traffic class byte
+        gint tos = sink->qos_dscp << 2;
+        gint result = family == AF_INET6 ?
+            setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos)) :
+            setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+        if (result < 0) {
+            LOGW("Could not set DSCP %d: %s", sink->qos_dscp, strerror(errno));
+        }
+    }
+
+    if (sink->dont_fragment >= 0) {
+        gint mode = sink->dont_fragment ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+        gint result = family == AF_INET6 ?
+            setsockopt(fd, IPPROTO_IPV6, IPV6_MTU_DISCOVER, &mode, sizeof(mode)) :
+            setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &mode, sizeof(mode));
+        if (result < 0) {
+            LOGW("Could not set don't-fragment policy: %s", strerror(errno));
+        }
+    }
+}
+
+static gboolean batched_udp_sink_start(GstBaseSink *basesink) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(basesink);
+
+    sink->socket_v4 = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sink->socket_v6 = socket(AF_INET6, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (sink->socket_v4 < 0 && sink->socket_v6 < 0) {
+        GST_ELEMENT_ERROR(sink, RESOURCE, OPEN_WRITE, (nullptr),
+                          ("Could not create UDP socket: %s", strerror(errno)));
+        return FALSE;
+    }
+
+    configure_socket(sink, sink->socket_v4, AF_INET);
+    configure_socket(sink, sink->socket_v6, AF_INET6);
+
+    // The socket option exists exactly where GSO sends are supported
+    gint probe = 0;
+    gint fd = sink->socket_v4 >= 0 ? sink->socket_v4 : sink->socket_v6;
+    sink->gso_supported = setsockopt(fd, SOL_UDP, UDP_SEGMENT, &probe, sizeof(probe)) == 0;
+    LOGI("Batched UDP sink started, GSO %s", sink->gso_supported ? "supported" : "unsupported");
+
+    sink->window_start_us = g_get_monotonic_time();
+    sink->flusher_stop = FALSE;
+    sink->flusher = g_thread_new("udp-batch-flush", flusher_loop, sink);
+
+    return TRUE;
+}
+
+static gboolean batched_udp_sink_stop(GstBaseSink *basesink) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(basesink);
+
+    g_mutex_lock(&sink->lock);
+    sink->flusher_stop = TRUE;
+    g_cond_signal(&sink->cond);
+    g_mutex_unlock(&sink->lock);
+
+    if (sink->flusher) {
+        g_thread_join(sink->flusher);
+        sink->flusher = nullptr;
+    }
+
+    g_mutex_lock(&sink->lock);
+    flush_locked(sink);
+    if (sink->socket_v4 >= 0) {
+        close(sink->socket_v4);
+        sink->socket_v4 = -1;
+    }
+    if (sink->socket_v6 >= 0) {
+        close(sink->socket_v6);
+        sink->socket_v6 = -1;
+    }
+    g_mutex_unlock(&sink->lock);
+
+    LOGI("Batched UDP sink: %llu packets in %llu syscalls, %llu errors (%llu EAGAIN, %llu ENOBUFS)",
+         (unsigned long long) sink->packets_sent, (unsigned long long) sink->syscalls,
+         (unsigned long long) sink->send_errors, (unsigned long long) sink->send_eagain,
+         (unsigned long long) sink->send_enobufs);
+    return TRUE;
+}
+
+/**
+ * Action signal handlers, same semantics as multiudpsink
+ */
+static void batched_udp_sink_add(BatchedUdpSink *sink, const gchar *host, gint port) {
+    struct addrinfo hints = {};
+    struct addrinfo *result = nullptr;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_NUMERICSERV;
+
+    std::string service = std::to_string(port);
+    gint error = getaddrinfo(host, service.c_str(), &hints, &result);
+    if (error != 0 || !result) {
+        LOGE("Could not resolve %s: %s", host, gai_strerror(error));
+        return;
+    }
+
+    BatchDestination destination;
+    destination.host = host;
+    destination.port = port;
+    memcpy(&destination.addr, result->ai_addr, result->ai_addrlen);
+    destination.addr_len = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    g_mutex_lock(&sink->lock);
+    // Pending packets were batched for the old destination set
+    flush_locked(sink);
+    sink->state->destinations.push_back(destination);
+    g_mutex_unlock(&sink->lock);
+}
+
+static void batched_udp_sink_remove(BatchedUdpSink *sink, const gchar *host, gint port) {
+    g_mutex_lock(&sink->lock);
+    flush_locked(sink);
+    std::vector<BatchDestination> &destinations = sink->state->destinations;
+    for (auto it = destinations.begin(); it != destinations.end(); ++it) {
+        if (it->host == host && it->port == port) {
+            destinations.erase(it);
+            break;
+        }
+    }
+    g_mutex_unlock(&sink->lock);
+}
+
+static void batched_udp_sink_clear(BatchedUdpSink *sink) {
+    g_mutex_lock(&sink->lock);
+    flush_locked(sink);
+    sink->state->destinations.clear();
+    g_mutex_unlock(&sink->lock);
+}
+
+/**
+ * "clients" property: comma-separated host:port list, like multiudpsink
+ */
+static void set_clients(BatchedUdpSink *sink, const gchar *clients) {
+    batched_udp_sink_clear(sink);
+    if (!clients) {
+        return;
+    }
+
+    gchar **entries = g_strsplit(clients, ",", -1);
+    for (gchar **entry = entries; *entry; entry++) {
+        gchar *separator = strrchr(*entry, ':');
+        if (!separator) {
+            continue;
+        }
+        std::string host(*entry, separator - *entry);
+        batched_udp_sink_add(sink, host.c_str(), atoi(separator + 1));
+    }
+    g_strfreev(entries);
+}
+
+static gchar *get_clients(BatchedUdpSink *sink) {
+    std::string clients;
+
+    g_mutex_lock(&sink->lock);
+    for (const BatchDestination &destination : sink->state->destinations) {
+        if (!clients.empty()) {
+            clients += ",";
+        }
+        clients += destination.host + ":" + std::to_string(destination.port);
+    }
+    g_mutex_unlock(&sink->lock);
+
+    return g_strdup(clients.c_str());
+}
+
+static void batched_udp_sink_set_property(GObject *object, guint prop_id,
+                                          const GValue *value, GParamSpec *pspec) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(object);
+
+    switch (prop_id) {
+        case PROP_CLIENTS:
+            set_clients(sink, g_value_get_string(value));
+            break;
+        case PROP_MAX_BATCH:
+            g_mutex_lock(&sink->lock);
+            sink->max_batch = g_value_get_uint(value);
+            g_mutex_unlock(&sink->lock);
+            break;
+        case PROP_MAX_LATENCY:
+            g_mutex_lock(&sink->lock);
+            sink->max_latency = g_value_get_uint64(value);
+            g_cond_signal(&sink->cond);
+            g_mutex_unlock(&sink->lock);
+            break;
+        case PROP_GSO:
+            g_mutex_lock(&sink->lock);
+            sink->gso = g_value_get_boolean(value);
+            g_mutex_unlock(&sink->lock);
+            break;
+        case PROP_BUFFER_SIZE:
+            sink->buffer_size = g_value_get_int(value);
+            break;
+        case PROP_QOS_DSCP:
+            sink->qos_dscp = g_value_get_int(value);
+            break;
+        case PROP_DONT_FRAGMENT:
+            sink->dont_fragment = g_value_get_int(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+}
+
+static void batched_udp_sink_get_property(GObject *object, guint prop_id,
+                                          GValue *value, GParamSpec *pspec) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(object);
+
+    if (prop_id == PROP_CLIENTS) {
+        g_value_take_string(value, get_clients(sink));
+        return;
+    }
+
+    g_mutex_lock(&sink->lock);
+    switch (prop_id) {
+        case PROP_MAX_BATCH:
+            g_value_set_uint(value, sink->max_batch);
+            break;
+        case PROP_MAX_LATENCY:
+            g_value_set_uint64(value, sink->max_latency);
+            break;
+        case PROP_GSO:
+            g_value_set_boolean(value, sink->gso);
+            break;
+        case PROP_SYSCALLS:
+            g_value_set_uint64(value, sink->syscalls);
+            break;
+        case PROP_PACKETS_SENT:
+            g_value_set_uint64(value, sink->packets_sent);
+            break;
+        case PROP_SEND_ERRORS:
+            g_value_set_uint64(value, sink->send_errors);
+            break;
+        case PROP_SYSCALLS_PER_SECOND:
+            g_value_set_double(value, sink->syscalls_per_second);
+            break;
+        case PROP_BUFFER_SIZE:
+            g_value_set_int(value, sink->buffer_size);
+            break;
+        case PROP_QOS_DSCP:
+            g_value_set_int(value, sink->qos_dscp);
+            break;
+        case PROP_DONT_FRAGMENT:
+            g_value_set_int(value, sink->dont_fragment);
+            break;
+        case PROP_SEND_EAGAIN:
+            g_value_set_uint64(value, sink->send_eagain);
+            break;
+        case PROP_SEND_ENOBUFS:
+            g_value_set_uint64(value, sink->send_enobufs);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&sink->lock);
+}
+
+static void batched_udp_sink_finalize(GObject *object) {
+    BatchedUdpSink *sink = BATCHED_UDP_SINK(object);
+
+    release_pending_locked(sink);
+    delete sink->state;
+    g_cond_clear(&sink->cond);
+    g_mutex_clear(&sink->lock);
+
+    G_OBJECT_CLASS(batched_udp_sink_parent_class)->finalize(object);
+}
+
+static void batched_udp_sink_class_init(BatchedUdpSinkClass *klass) {
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+    GstBaseSinkClass *basesink_class = GST_BASE_SINK_CLASS(klass);
+
+    gobject_class->set_property = batched_udp_sink_set_property;
+    gobject_class->get_property = batched_udp_sink_get_property;
+    gobject_class->finalize = batched_udp_sink_finalize;
+
+    GParamFlags readwrite = (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+    GParamFlags readable = (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_property(gobject_class, PROP_CLIENTS,
+        g_param_spec_string("clients", "Clients",
+            "Comma-separated list of host:port destinations", nullptr, readwrite));
+    g_object_class_install_property(gobject_class, PROP_MAX_BATCH,
+        g_param_spec_uint("max-batch", "Max batch",
+            "Packet copies (packets x destinations) queued before sending", 1, 1024,
+            DEFAULT_MAX_BATCH, readwrite));
+    g_object_class_install_property(gobject_class, PROP_MAX_LATENCY,
+        g_param_spec_uint64("max-latency", "Max latency",
+            "Longest a packet waits for its batch, in nanoseconds (0 = send immediately)",
+            0, GST_SECOND, DEFAULT_MAX_LATENCY, readwrite));
+    g_object_class_install_property(gobject_class, PROP_GSO,
+        g_param_spec_boolean("gso", "GSO",
+            "Merge same-sized packets to one destination with UDP GSO when supported",
+            TRUE, readwrite));
+    g_object_class_install_property(gobject_class, PROP_SYSCALLS,
+        g_param_spec_uint64("syscalls", "Syscalls",
+            "sendmmsg calls made", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_PACKETS_SENT,
+        g_param_spec_uint64("packets-sent", "Packets sent",
+            "Packet copies handed to the kernel", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_SEND_ERRORS,
+        g_param_spec_uint64("send-errors", "Send errors",
+            "Failed sends", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_SYSCALLS_PER_SECOND,
+        g_param_spec_double("syscalls-per-second", "Syscalls per second",
+            "sendmmsg rate over the last full second", 0, G_MAXDOUBLE, 0, readable));
+
+    g_object_class_install_property(gobject_class, PROP_BUFFER_SIZE,
+        g_param_spec_int("buffer-size", "Buffer size",
+            "SO_SNDBUF in bytes, applied when the sockets open (-1 = kernel default)",
+            SOCKET_OPTION_DEFAULT, G_MAXINT, SOCKET_OPTION_DEFAULT, readwrite));
+    g_object_class_install_property(gobject_class, PROP_QOS_DSCP,
+        g_param_spec_int("qos-dscp", "QoS DSCP",
+            "DSCP code point for sent packets (-1 = leave unmarked)",
+            SOCKET_OPTION_DEFAULT, 63, SOCKET_OPTION_DEFAULT, readwrite));
+    g_object_class_install_property(gobject_class, PROP_DONT_FRAGMENT,
+        g_param_spec_int("dont-fragment", "Don't fragment",
+            "1 sets DF and never fragments, 0 allows fragmentation (-1 = kernel default)",
+            SOCKET_OPTION_DEFAULT, 1, SOCKET_OPTION_DEFAULT, readwrite));
+    g_object_class_install_property(gobject_class, PROP_SEND_EAGAIN,
+        g_param_spec_uint64("send-eagain", "Send EAGAIN",
+            "Sends dropped because the socket buffer was full", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_SEND_ENOBUFS,
+        g_param_spec_uint64("send-enobufs", "Send ENOBUFS",
+            "Sends dropped because the interface queue was full", 0, G_MAXUINT64, 0, readable));
+
+    GSignalFlags action = (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION);
+    batched_udp_sink_signals[SIGNAL_ADD] = g_signal_new("add", G_TYPE_FROM_CLASS(klass), action,
+        G_STRUCT_OFFSET(BatchedUdpSinkClass, add), nullptr, nullptr, nullptr,
+        G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+    batched_udp_sink_signals[SIGNAL_REMOVE] = g_signal_new("remove", G_TYPE_FROM_CLASS(klass), action,
+        G_STRUCT_OFFSET(BatchedUdpSinkClass, remove), nullptr, nullptr, nullptr,
+        G_TYPE_NONE, 2, G_TYPE_STRING, G_TYPE_INT);
+    batched_udp_sink_signals[SIGNAL_CLEAR] = g_signal_new("clear", G_TYPE_FROM_CLASS(klass), action,
+        G_STRUCT_OFFSET(BatchedUdpSinkClass, clear), nullptr, nullptr, nullptr,
+        G_TYPE_NONE, 0);
+
+    klass->add = batched_udp_sink_add;
+    klass->remove = batched_udp_sink_remove;
+    klass->clear = batched_udp_sink_clear;
+
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_set_static_metadata(element_class,
+        "Batched UDP packet sender", "Sink/Network",
+        "Sends packets to multiple clients with batched sendmmsg and UDP GSO",
+        "HeavenWaves");
+
+    basesink_class->render = batched_udp_sink_render;
+    basesink_class->render_list = batched_udp_sink_render_list;
+    basesink_class->event = batched_udp_sink_event;
+    basesink_class->start = batched_udp_sink_start;
+    basesink_class->stop = batched_udp_sink_stop;
+}
+
+static void batched_udp_sink_init(BatchedUdpSink *sink) {
+    g_mutex_init(&sink->lock);
+    g_cond_init(&sink->cond);
+    sink->state = new BatchState();
+
+    sink->socket_v4 = -1;
+    sink->socket_v6 = -1;
+    sink->max_batch = DEFAULT_MAX_BATCH;
+    sink->max_latency = DEFAULT_MAX_LATENCY;
+    sink->gso = TRUE;
+    sink->buffer_size = SOCKET_OPTION_DEFAULT;
+    sink->qos_dscp = SOCKET_OPTION_DEFAULT;
+    sink->dont_fragment = SOCKET_OPTION_DEFAULT;
+}
+
+extern "C" {
+
+/**
+ * Register batchudpsink with the element registry
+ * Called from native-audio-bridge.cpp before a pipeline uses it
+ */
+gboolean register_batched_udp_sink(void) {
+    return gst_element_register(nullptr, "batchudpsink", GST_RANK_NONE, batched_udp_sink_get_type());
+}
+
+} // extern "C"
@@ -0,0 +1,87 @@
+/*
+ * bitrate-controller.h
+ *
+ * Receiver-report driven bitrate adaptation, kept free of GLib so it builds
+ * and is tested on the host
+ */
+
+#ifndef HEAVENWAVES_BITRATE_CONTROLLER_H
+#define HEAVENWAVES_BITRATE_CONTROLLER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * BitrateController - Adapts opusenc to RTCP receiver reports
+ *
+ * Loss is smoothed across reports. Congestion (loss above 5% or jitter
+ * above 30 ms) cuts the bitrate straight away; only after several clean
+ * reports in a row (loss below 1%, jitter below 15 ms) is it raised again,
+ * in smaller steps. The gap between the two thresholds and the clean-report
+ * count are the hysteresis that keeps it from oscillating.
+ */
+class BitrateController {
+    private:
+        int min_bitrate;
+        int max_bitrate;
+        int bitrate;
+        double smoothed_loss = -1.0;
+        unsigned clean_reports = 0;
+        int loss_percentage = 0;
+
+        static constexpr double LOSS_SMOOTHING = 0.3;
+        static constexpr double CONGESTED_LOSS = 0.05;
+        static constexpr double CLEAN_LOSS = 0.01;
+        static constexpr double CONGESTED_JITTER_MS = 30.0;
+        static constexpr double CLEAN_JITTER_MS = 15.0;
+        static constexpr unsigned CLEAN_REPORTS_TO_RAISE = 3;
+
+    public:
+        BitrateController(int min, int max) :
+            min_bitrate(std::min(min, max)), max_bitrate(max), bitrate(max) {}
+
+        /**
+         * Feed one report block, returns true when the encoder needs updating
+         */
+        bool on_report(uint8_t fraction_lost, double jitter_ms) {
+            double loss = fraction_lost / 256.0;
+            smoothed_loss = smoothed_loss < 0 ? loss :
+                LOSS_SMOOTHING * loss + (1.0 - LOSS_SMOOTHING) * smoothed_loss;
+
+            int previous_bitrate = bitrate;
+            int previous_loss = loss_percentage;
+
+            if (smoothed_loss > CONGESTED_LOSS || jitter_ms > CONGESTED_JITTER_MS) {
+                // Heavy loss backs off harder
+                bitrate = (int) (bitrate * (smoothed_loss > 2 * CONGESTED_LOSS ? 0.6 : 0.8));
+                clean_reports = 0;
+            } else if (smoothed_loss < CLEAN_LOSS && jitter_ms < CLEAN_JITTER_MS) {
+                if (++clean_reports >= CLEAN_REPORTS_TO_RAISE) {
+                    bitrate = (int) (bitrate * 1.1);
+                    clean_reports = 0;
+                }
+            } else {
+                clean_reports = 0;
+            }
+            bitrate = std::max(min_bitrate, std::min(bitrate, max_bitrate));
+
+            // Tell the encoder how much loss to protect against (in-band FEC)
+            int percentage = std::max(0, std::min((int) (smoothed_loss * 100.0 + 0.5), 100));
+            if (std::abs(percentage - loss_percentage) >= 2 || (percentage == 0 && loss_percentage != 0)) {
+                loss_percentage = percentage;
+            }
+
+            return bitrate != previous_bitrate || loss_percentage != previous_loss;
+        }
+
+        int get_bitrate() const {
+            return bitrate;
+        }
+
+        int get_loss_percentage() const {
+            return loss_percentage;
+        }
+};
+
+#endif // HEAVENWAVES_BITRATE_CONTROLLER_H
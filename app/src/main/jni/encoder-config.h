@@ -0,0 +1,137 @@
+/*
+ * encoder-config.h
+ *
+ * opusenc and RTP FEC settings, kept free of GLib so they build and are
+ * tested on the host
+ */
+
+#ifndef HEAVENWAVES_ENCODER_CONFIG_H
+#define HEAVENWAVES_ENCODER_CONFIG_H
+
+#include <algorithm>
+#include <string>
+
+/**
+ * EncoderConfig - opusenc tuning
+ *
+ * Named presets cover the common trade-offs; individual fields can still be
+ * overridden from the pipeline options (encoder-* keys).
+ */
+struct EncoderConfig {
+    int frame_size_us = 20000;         // 2500, 5000, 10000, 20000, 40000 or 60000
+    int complexity = 10;               // 0 (fastest) - 10 (best)
+    std::string bitrate_type = "cbr";  // cbr, vbr or constrained-vbr
+    std::string audio_type = "generic"; // generic, voice or restricted-lowdelay
+    bool inband_fec = false;
+    int packet_loss_percentage = 0;
+    bool dtx = false;
+    unsigned max_payload_size = 4000;
+
+    // RTP-level FEC after the payloader
+    std::string fec = "none";          // none, red or ulpfec
+    unsigned fec_distance = 1;         // red: earlier frames repeated in each packet,
+                                       // ulpfec: > 1 protects across several packets
+    unsigned fec_percentage = 0;       // ulpfec: repair packets per 100 media packets
+
+    /**
+     * Load a named preset, returns false for unknown names
+     *
+     * - ultra-low-latency: 5 ms CELT-only frames for LAN links
+     * - balanced: 10 ms frames at moderate complexity with loss resilience
+     * - lossy-link: balanced plus RED, each packet repeats the previous frame
+     * - low-cpu: 20 ms frames at low complexity for older devices
+     * - default: opusenc's own defaults
+     */
+    bool load_preset(const std::string &name) {
+        *this = EncoderConfig();
+
+        if (name == "ultra-low-latency") {
+            frame_size_us = 5000;
+            complexity = 5;
+            audio_type = "restricted-lowdelay";
+            max_payload_size = 1200;
+        } else if (name == "balanced") {
+            frame_size_us = 10000;
+            complexity = 7;
+            bitrate_type = "constrained-vbr";
+            inband_fec = true;
+            packet_loss_percentage = 5;
+        } else if (name == "lossy-link") {
+            frame_size_us = 10000;
+            complexity = 7;
+            bitrate_type = "constrained-vbr";
+            inband_fec = true;
+            packet_loss_percentage = 10;
+            fec = "red";
+            fec_distance = 1;
+        } else if (name == "low-cpu") {
+            frame_size_us = 20000;
+            complexity = 2;
+        } else if (name != "default") {
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * Apply encoder-* overrides from the pipeline options. Options provides
+     * get_int/get_uint/get_bool, which leave the value alone for absent
+     * keys, and get_string, which returns nullptr for them.
+     */
+    template <typename Options>
+    void apply_overrides(const Options &options) {
+        const char *value;
+
+        options.get_int("encoder-frame-size-us", frame_size_us);
+        options.get_int("encoder-complexity", complexity);
+        if ((value = options.get_string("encoder-bitrate-type"))) {
+            bitrate_type = value;
+        }
+        if ((value = options.get_string("encoder-audio-type"))) {
+            audio_type = value;
+        }
+        options.get_bool("encoder-inband-fec", inband_fec);
+        options.get_int("encoder-packet-loss-percentage", packet_loss_percentage);
+        options.get_bool("encoder-dtx", dtx);
+        options.get_uint("encoder-max-payload-size", max_payload_size);
+        if ((value = options.get_string("encoder-fec"))) {
+            fec = value;
+        }
+        options.get_uint("encoder-fec-distance", fec_distance);
+        options.get_uint("encoder-fec-percentage", fec_percentage);
+    }
+
+    /**
+     * opusenc's frame-size enum nick for frame_size_us
+     */
+    std::string frame_size_nick() const {
+        return frame_size_us == 2500 ? "2.5" : std::to_string(frame_size_us / 1000);
+    }
+
+    /**
+     * Extra delay a receiver needs to make use of the FEC stage
+     */
+    unsigned fec_latency_ms() const {
+        if (fec == "red") {
+            return fec_distance * frame_size_us / 1000;
+        } else if (fec == "ulpfec" && fec_percentage > 0) {
+            // Repair packets trail the media packets they protect
+            return std::max(fec_distance, 1u) * 2 * frame_size_us / 1000;
+        }
+        return 0;
+    }
+
+    std::string describe() const {
+        return "frame-size=" + frame_size_nick() + "ms complexity=" + std::to_string(complexity) +
+            " bitrate-type=" + bitrate_type + " audio-type=" + audio_type +
+            " inband-fec=" + (inband_fec ? "true" : "false") +
+            " packet-loss-percentage=" + std::to_string(packet_loss_percentage) +
+            " dtx=" + (dtx ? "true" : "false") +
+            " max-payload-size=" + std::to_string(max_payload_size) +
+            " fec=" + fec + (fec == "none" ? "" :
+                " distance=" + std::to_string(fec_distance) +
+                (fec == "ulpfec" ? " percentage=" + std::to_string(fec_percentage) : ""));
+    }
+};
+
+#endif // HEAVENWAVES_ENCODER_CONFIG_H
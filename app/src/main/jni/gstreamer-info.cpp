@@ -5,14 +5,84 @@
 
 #define LOG_TAG "GStreamerHelloWorld"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+// Implemented in native-audio-bridge.cpp
+extern "C" void preload_element_factories(const char *const *plugins);
+
+// Plugins the streaming profiles build their pipelines from. coreelements
+// (queue, tee, capsfilter) and rtpmanager (rtpbin, rtprtxsend) come along
+// with the codec and transport plugins.
+static const char *const required_plugins[] = {
+    "coreelements", "app", "audioconvert", "audioresample", "opus", "rtp", "rtpmanager", "udp", NULL
+};
+
+/**
+ * Startup timings, in the order nativeGetStartupTimings returns them
+ * (GStreamer.STARTUP_*). -1 until the phase has run.
+ */
+enum {
+    STARTUP_REGISTRY_US,
+    STARTUP_PLUGINS_US,
+    STARTUP_FIRST_PIPELINE_US,
+    STARTUP_PLUGIN_COUNT,
+    STARTUP_TIMING_COUNT
+};
+
+static gint64 startup_timings[STARTUP_TIMING_COUNT] = { -1, -1, -1, -1 };
+G_LOCK_DEFINE_STATIC(startup_timings);
+
+static void set_startup_timing(int index, gint64 value) {
+    G_LOCK(startup_timings);
+    startup_timings[index] = value;
+    G_UNLOCK(startup_timings);
+}
+
+/**
+ * Load the plugins the pipelines need. Static plugins are already loaded
+ * by gst_init, this only matters for plugins coming from disk.
+ */
+static guint load_required_plugins(void) {
+    GstRegistry *registry = gst_registry_get();
+    guint loaded = 0;
+
+    for (const char *const *name = required_plugins; *name; name++) {
+        GstPlugin *plugin = gst_registry_find_plugin(registry, *name);
+        if (!plugin) {
+            LOGE("Required plugin %s not found", *name);
+            continue;
+        }
+
+        if (!gst_plugin_is_loaded(plugin)) {
+            GstPlugin *loaded_plugin = gst_plugin_load(plugin);
+            if (loaded_plugin) {
+                gst_object_unref(loaded_plugin);
+            } else {
+                LOGE("Failed to load plugin %s", *name);
+            }
+        }
+        gst_object_unref(plugin);
+        loaded++;
+    }
+
+    return loaded;
+}
+
 // Native method to initialize GStreamer
-static void gst_native_init(JNIEnv *env, jclass klass) {
+static void gst_native_init(JNIEnv *env, jclass klass, jobject context, jboolean selective) {
     GError *error = NULL;
 
-    LOGD("Initializing GStreamer...");
+    LOGD("Initializing GStreamer (%s plugin preload)...", selective ? "selective" : "full");
 
+    if (selective) {
+        // Everything the app uses is linked in statically: don't rescan
+        // plugin paths or fork a scanner process on every launch
+        g_setenv("GST_REGISTRY_UPDATE", "no", TRUE);
+        gst_registry_fork_set_enabled(FALSE);
+    }
+
+    gint64 begin = g_get_monotonic_time();
     if (!gst_init_check(NULL, NULL, &error)) {
         LOGE("Failed to initialize GStreamer: %s", error ? error->message : "Unknown error");
         if (error) {
@@ -20,8 +90,27 @@ static void gst_native_init(JNIEnv *env, jclass klass) {
         }
         return;
     }
+    set_startup_timing(STARTUP_REGISTRY_US, g_get_monotonic_time() - begin);
 
-    LOGD("GStreamer initialized successfully");
+    // Load plugins and look up the pipeline's element factories now rather
+    // than on first init
+    begin = g_get_monotonic_time();
+    if (selective) {
+        load_required_plugins();
+        preload_element_factories(required_plugins);
+    } else {
+        preload_element_factories(NULL);
+    }
+    set_startup_timing(STARTUP_PLUGINS_US, g_get_monotonic_time() - begin);
+
+    GList *plugins = gst_registry_get_plugin_list(gst_registry_get());
+    set_startup_timing(STARTUP_PLUGIN_COUNT, g_list_length(plugins));
+    gst_plugin_list_free(plugins);
+
+    LOGI("GStreamer initialized: registry %.2fms, plugins %.2fms, %lld plugins registered",
+         startup_timings[STARTUP_REGISTRY_US] / 1000.0,
+         startup_timings[STARTUP_PLUGINS_US] / 1000.0,
+         (long long) startup_timings[STARTUP_PLUGIN_COUNT]);
 }
 
 // Native method to get GStreamer version information
@@ -35,12 +124,44 @@ static jstring gst_native_get_gstreamer_info(JNIEnv *env, jclass klass) {
     return version_jstring;
 }
 
+// Native method to get the startup timings
+static jlongArray gst_native_get_startup_timings(JNIEnv *env, jclass klass) {
+    jlong values[STARTUP_TIMING_COUNT];
+
+    G_LOCK(startup_timings);
+    for (int i = 0; i < STARTUP_TIMING_COUNT; i++) {
+        values[i] = (jlong) startup_timings[i];
+    }
+    G_UNLOCK(startup_timings);
+
+    jlongArray result = env->NewLongArray(STARTUP_TIMING_COUNT);
+    if (result) {
+        env->SetLongArrayRegion(result, 0, STARTUP_TIMING_COUNT, values);
+    }
+    return result;
+}
+
 // JNI method registration - exported for use in combined JNI_OnLoad
 extern "C" {
 
+/**
+ * Record how long the first pipeline took to build
+ * Called from AudioPipeline::init in native-audio-bridge.cpp, only the first
+ * call counts
+ */
+void record_first_pipeline_time(gint64 elapsed_us) {
+    G_LOCK(startup_timings);
+    if (startup_timings[STARTUP_FIRST_PIPELINE_US] < 0) {
+        startup_timings[STARTUP_FIRST_PIPELINE_US] = elapsed_us;
+        LOGI("First pipeline built in %.2fms", elapsed_us / 1000.0);
+    }
+    G_UNLOCK(startup_timings);
+}
+
 static JNINativeMethod gstreamer_native_methods[] = {
-    {"nativeInit", "(Landroid/content/Context;)V", (void *)gst_native_init},
-    {"nativeGetGStreamerInfo", "()Ljava/lang/String;", (void *)gst_native_get_gstreamer_info}
+    {"nativeInit", "(Landroid/content/Context;Z)V", (void *)gst_native_init},
+    {"nativeGetGStreamerInfo", "()Ljava/lang/String;", (void *)gst_native_get_gstreamer_info},
+    {"nativeGetStartupTimings", "()[J", (void *)gst_native_get_startup_timings}
 };
 
 /**
@@ -66,4 +187,4 @@ jint register_gstreamer_methods(JNIEnv *env) {
     return JNI_OK;
 }
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
@@ -8,9 +8,26 @@
 #include <jni.h>
 #include <string>
 #include <memory>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+#include <pthread.h>
 #include <android/log.h>
 #include <gst/gst.h>
+#include <gio/gio.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
 #include <gst/app/gstappsrc.h>
+#include <gst/rtp/gstrtcpbuffer.h>
+
+#include "spsc-ring.h"
+#include "bitrate-controller.h"
+#include "encoder-config.h"
 
 #define LOG_TAG "NativeAudioBridge"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -18,299 +35,3475 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
-/**
- * AudioPipeline - Encapsulates GStreamer pipeline state and operations
- *
- * Design follows GStreamer best practices:
- * - Uses gst_parse_launch for simple pipeline creation
- * - Proper reference counting with GStreamer objects
- * - Bus watch for message handling
- * - Clean state transitions
- */
-class AudioPipeline {
-    private:
-        GstElement *pipeline = nullptr;
-        GstElement *appsrc = nullptr;
-        GstBus *bus = nullptr;
-        guint bus_watch_id = 0;
+// Number of native slabs that can be lent to the capture thread at once
+#define DIRECT_SLAB_COUNT 8
+
+// Audio kept preallocated in the push_data buffer pool
+#define BUFFER_POOL_PREALLOC_MS 200
+
+// RTP and RTCP ports on both ends of the stream
+#define RTP_PORT 5004
+#define RTCP_PORT 5005
+
+// RTP payload types: Opus media, RED redundancy and ULPFEC repair packets
+#define OPUS_PAYLOAD_TYPE 96
+#define RED_PAYLOAD_TYPE 100
+#define ULPFEC_PAYLOAD_TYPE 101
+
+// RFC 4588 retransmission payload types for Opus and RED packets
+#define OPUS_RTX_PAYLOAD_TYPE 97
+#define RED_RTX_PAYLOAD_TYPE 98
+
+// Sent packets kept for retransmission
+#define DEFAULT_RTX_HISTORY_MS 500
+
+// Largest IP packet the RTP path produces, headers included
+#define DEFAULT_RTP_MTU 1400
+
+// Jitter buffer a receiver needs on a clean link, before FEC delay
+#define RECEIVER_LATENCY_MS 40
+
+// Local TCP server: default port and per-client backlog before the
+// slow-client policy applies
+#define DEFAULT_TCP_PORT 5006
+#define DEFAULT_TCP_CLIENT_QUEUE_MS 500
+
+// Encoded audio the file branch may buffer before it starts dropping
+#define FILE_QUEUE_MAX_MS 2000
+
+// Default capacity of the capture -> pusher ring
+#define DEFAULT_RING_CAPACITY_MS 200
+
+// Capture running this far behind the pipeline clock is treated as a skip
+#define DISCONT_THRESHOLD_MS 100
+
+// Ring overruns are reported at most this often
+#define OVERRUN_REPORT_INTERVAL_MS 1000
+
+// How long a stop may drain before the pipeline is forced to NULL
+#define DEFAULT_STOP_DEADLINE_MS 3000
+
+// Bus events are handed to Java at most this often; errors go out at once
+#define EVENT_BATCH_MS 50
+#define MAX_PENDING_EVENTS 64
+
+// Cached VM - needed to release global references outside of a JNI call
+static JavaVM *g_jvm = nullptr;
+
+// AudioCaptureService.onPipelineEvents(long session, int[] types, String[] messages) and
+// String, looked up in JNI_OnLoad for the bus threads
+static jmethodID g_on_pipeline_events = nullptr;
+static jclass g_string_class = nullptr;
+
+// Forward declaration - implemented in batched-udp-sink.cpp
+extern "C" gboolean register_batched_udp_sink(void);
+
+// Forward declaration - implemented in opus-aggregator.cpp
+extern "C" gboolean register_opus_aggregator(void);
+
+// Forward declaration - implemented in gstreamer-info.cpp
+extern "C" void record_first_pipeline_time(gint64 elapsed_us);
+
+/**
+ * Register batchudpsink once per process
+ */
+static bool ensure_batched_udp_sink() {
+    static gsize registered = 0;
+    if (g_once_init_enter(&registered)) {
+        g_once_init_leave(&registered, register_batched_udp_sink() ? 1 : 2);
+    }
+    return registered == 1;
+}
+
+/**
+ * Register opusaggregate once per process
+ */
+static bool ensure_opus_aggregator() {
+    static gsize registered = 0;
+    if (g_once_init_enter(&registered)) {
+        g_once_init_leave(&registered, register_opus_aggregator() ? 1 : 2);
+    }
+    return registered == 1;
+}
+
+/**
+ * ElementFactoryCache - Element factories the pipeline is built from
+ *
+ * Looking a factory up walks the registry and the first create loads its
+ * plugin feature, so both are done once, from gst_native_init, instead of
+ * on every init. Factories not in the preload list are looked up and kept
+ * on first use. Cached factories hold a reference for the process lifetime.
+ */
+class ElementFactoryCache {
+    public:
+        /**
+         * Look up and load the pipeline's factories. With a plugin list only
+         * factories from those plugins (and our own elements) are loaded up
+         * front; the rest are left to the first get().
+         */
+        static void preload(const char *const *plugins) {
+            static const char *const factories[] = {
+                "appsrc", "audioconvert", "audioresample", "opusenc", "opusaggregate",
+                "rtpopuspay", "rtpulpfecenc", "rtpredenc", "rtprtxsend", "rtpbin",
+                "multiudpsink", "batchudpsink", "udpsrc", "tee", "queue",
+                "oggmux", "filesink", "rtpstreampay", "tcpserversink"
+            };
+
+            static gsize loaded = 0;
+            if (!g_once_init_enter(&loaded)) {
+                return;
+            }
+
+            gint64 begin = g_get_monotonic_time();
+            ensure_batched_udp_sink();
+            ensure_opus_aggregator();
+
+            guint found = 0;
+            for (const char *name : factories) {
+                if (plugins && !from_plugins(name, plugins)) {
+                    continue;
+                }
+                if (get(name)) {
+                    found++;
+                } else {
+                    LOGW("Element factory %s not available", name);
+                }
+            }
+
+            LOGI("Preloaded %u/%zu element factories in %.2fms", found, G_N_ELEMENTS(factories),
+                 (g_get_monotonic_time() - begin) / 1000.0);
+            g_once_init_leave(&loaded, 1);
+        }
+
+        /**
+         * Cached factory by name, nullptr when no such element exists.
+         * The cache keeps the reference.
+         */
+        static GstElementFactory *get(const char *name) {
+            Entries &cache = entries();
+            std::lock_guard<std::mutex> lock(cache.mutex);
+
+            auto it = cache.factories.find(name);
+            if (it != cache.factories.end()) {
+                return it->second;
+            }
+
+            GstElementFactory *factory = gst_element_factory_find(name);
+            if (!factory) {
+                return nullptr;
+            }
+
+            // Load the plugin now so the first create doesn't have to
+            GstPluginFeature *loaded = gst_plugin_feature_load(GST_PLUGIN_FEATURE(factory));
+            if (loaded) {
+                gst_object_unref(factory);
+                factory = GST_ELEMENT_FACTORY(loaded);
+            }
+
+            cache.factories.emplace(name, factory);
+            return factory;
+        }
+
+    private:
+        /**
+         * Whether a factory comes from one of the plugins, or from no plugin
+         * at all as our statically registered elements do. Only reads the
+         * registry, nothing gets loaded.
+         */
+        static bool from_plugins(const char *name, const char *const *plugins) {
+            GstPluginFeature *feature = gst_registry_lookup_feature(gst_registry_get(), name);
+            if (!feature) {
+                return false;
+            }
+
+            const gchar *plugin = gst_plugin_feature_get_plugin_name(feature);
+            bool wanted = !plugin || g_strv_contains(plugins, plugin);
+            gst_object_unref(feature);
+            return wanted;
+        }
+
+        struct Entries {
+            std::mutex mutex;
+            std::unordered_map<std::string, GstElementFactory*> factories;
+        };
+
+        static Entries &entries() {
+            static Entries cache;
+            return cache;
+        }
+};
+
+extern "C" void preload_element_factories(const char *const *plugins) {
+    ElementFactoryCache::preload(plugins);
+}
+
+/**
+ * PipelineBuilder - Builds a bin from cached factories with typed links
+ *
+ * Elements are created straight from ElementFactoryCache and added to the
+ * bin, and links can carry explicit caps. The first failure is kept and
+ * every later call turns into a no-op, so a whole graph is built in one
+ * pass and checked once at the end. Time spent creating and linking is
+ * accumulated for the init timing stats.
+ */
+class PipelineBuilder {
+    public:
+        explicit PipelineBuilder(GstBin *bin) : bin(bin) {}
+
+        /**
+         * Create an element and add it to the bin
+         */
+        GstElement *make(const char *factory_name, const char *name = nullptr) {
+            if (failed()) {
+                return nullptr;
+            }
+
+            gint64 begin = g_get_monotonic_time();
+            GstElementFactory *factory = ElementFactoryCache::get(factory_name);
+            GstElement *element = factory ? gst_element_factory_create(factory, name) : nullptr;
+            create_us += g_get_monotonic_time() - begin;
+
+            if (!element) {
+                fail(std::string("Failed to create ") + factory_name);
+                return nullptr;
+            }
+
+            gst_bin_add(bin, element);
+            return element;
+        }
+
+        /**
+         * Link two elements, restricted to caps when given. Takes ownership
+         * of caps.
+         */
+        bool link(GstElement *src, GstElement *sink, GstCaps *caps = nullptr) {
+            bool linked = false;
+            if (!failed() && src && sink) {
+                gint64 begin = g_get_monotonic_time();
+                linked = gst_element_link_filtered(src, sink, caps);
+                link_us += g_get_monotonic_time() - begin;
+
+                if (!linked) {
+                    fail(std::string("Failed to link ") + GST_ELEMENT_NAME(src) + " to " + GST_ELEMENT_NAME(sink));
+                }
+            }
+
+            if (caps) {
+                gst_caps_unref(caps);
+            }
+            return linked;
+        }
+
+        /**
+         * Link named pads, requesting them when the element has them as
+         * request pads (rtpbin's session pads)
+         */
+        bool link_pads(GstElement *src, const char *src_pad, GstElement *sink, const char *sink_pad) {
+            if (failed() || !src || !sink) {
+                return false;
+            }
+
+            gint64 begin = g_get_monotonic_time();
+            bool linked = gst_element_link_pads(src, src_pad, sink, sink_pad);
+            link_us += g_get_monotonic_time() - begin;
+
+            if (!linked) {
+                fail(std::string("Failed to link ") + GST_ELEMENT_NAME(src) + "." + src_pad +
+                     " to " + GST_ELEMENT_NAME(sink) + "." + sink_pad);
+            }
+            return linked;
+        }
+
+        /**
+         * Link a chain of elements in order, skipping nullptr entries
+         */
+        bool link_chain(std::initializer_list<GstElement*> elements) {
+            GstElement *previous = nullptr;
+            for (GstElement *element : elements) {
+                if (!element) {
+                    continue;
+                }
+                if (previous && !link(previous, element)) {
+                    return false;
+                }
+                previous = element;
+            }
+            return !failed();
+        }
+
+        void fail(const std::string &message) {
+            if (error.empty()) {
+                error = message;
+            }
+        }
+
+        bool failed() const {
+            return !error.empty();
+        }
+
+        const std::string &get_error() const {
+            return error;
+        }
+
+        gint64 get_create_us() const {
+            return create_us;
+        }
+
+        gint64 get_link_us() const {
+            return link_us;
+        }
+
+    private:
+        GstBin *bin;
+        std::string error;
+        gint64 create_us = 0;
+        gint64 link_us = 0;
+};
+
+/**
+ * DirectBufferPool - Native memory slabs lent to Java as direct ByteBuffers
+ *
+ * AudioRecord reads straight into a lent slab and the slab memory is then
+ * wrapped in a GstBuffer without copying. The buffer's release notify hands
+ * the slab back to the pool once downstream is done with it.
+ *
+ * Slab ownership: FREE (in pool) -> LENT (held by Java) -> QUEUED (owned by
+ * a GstBuffer) -> FREE. Transitions are single atomic operations so the
+ * capture thread and the streaming threads never take a lock.
+ */
+class DirectBufferPool {
+    public:
+        enum SlabState { SLAB_FREE, SLAB_LENT, SLAB_QUEUED };
+
+        struct Slab {
+            DirectBufferPool *pool = nullptr;
+            guint8 *data = nullptr;
+            jobject byte_buffer = nullptr;
+            std::atomic<int> state{SLAB_FREE};
+        };
+
+    private:
+        std::vector<std::unique_ptr<Slab>> slabs;
+        gsize slab_size = 0;
+
+    public:
+        /**
+         * Allocate the slabs and their ByteBuffer wrappers up front so the
+         * capture loop never allocates, neither natively nor on the Java heap
+         */
+        bool init(JNIEnv *env, gsize size, guint count) {
+            slab_size = size;
+
+            for (guint i = 0; i < count; i++) {
+                auto slab = std::make_unique<Slab>();
+                slab->pool = this;
+                slab->data = static_cast<guint8*>(g_malloc(size));
+
+                jobject local = env->NewDirectByteBuffer(slab->data, static_cast<jlong>(size));
+                if (!local) {
+                    LOGE("Failed to create direct ByteBuffer for slab %u", i);
+                    g_free(slab->data);
+                    return false;
+                }
+
+                slab->byte_buffer = env->NewGlobalRef(local);
+                env->DeleteLocalRef(local);
+                slabs.push_back(std::move(slab));
+            }
+
+            LOGI("Direct buffer pool ready: %u slabs of %zu bytes", count, size);
+            return true;
+        }
+
+        gsize get_slab_size() const {
+            return slab_size;
+        }
+
+        /**
+         * Lend a free slab to Java, returns nullptr when every slab is in use
+         */
+        Slab *lend() {
+            for (auto &slab : slabs) {
+                int expected = SLAB_FREE;
+                if (slab->state.compare_exchange_strong(expected, SLAB_LENT)) {
+                    return slab.get();
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Find the lent slab backing a direct ByteBuffer address
+         */
+        Slab *find_lent(const void *address) {
+            for (auto &slab : slabs) {
+                if (slab->data == address && slab->state.load() == SLAB_LENT) {
+                    return slab.get();
+                }
+            }
+            return nullptr;
+        }
+
+        /**
+         * Wrap a lent slab in a GstBuffer; the slab returns to the pool when
+         * the buffer is freed
+         */
+        GstBuffer *wrap(Slab *slab, gsize size) {
+            slab->state.store(SLAB_QUEUED);
+            return gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+                slab->data, slab_size, 0, size,
+                slab, release_slab);
+        }
+
+        /**
+         * Hand a lent slab back without pushing it (e.g. an empty read)
+         */
+        static void give_back(Slab *slab) {
+            slab->state.store(SLAB_FREE);
+        }
+
+        static void release_slab(gpointer data) {
+            give_back(static_cast<Slab*>(data));
+        }
+
+        /**
+         * Free the slabs. Must run after the pipeline reached NULL so no
+         * GstBuffer references slab memory any more. Slabs still lent to Java
+         * are leaked on purpose: AudioRecord may be writing into them.
+         */
+        ~DirectBufferPool() {
+            JNIEnv *env = nullptr;
+            if (g_jvm) {
+                g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
+            }
+
+            for (auto &slab : slabs) {
+                if (env && slab->byte_buffer) {
+                    env->DeleteGlobalRef(slab->byte_buffer);
+                }
+
+                if (slab->state.load() == SLAB_LENT) {
+                    LOGW("Slab still lent to Java at pool teardown, leaking %zu bytes", slab_size);
+                    continue;
+                }
+
+                g_free(slab->data);
+            }
+        }
+};
+
+/**
+ * BackpressurePolicy - What happens to capture when appsrc is full
+ */
+enum BackpressurePolicy {
+    BACKPRESSURE_BLOCK,       // appsrc blocks the pusher, the ring blocks the producer
+    BACKPRESSURE_DROP_OLDEST, // the pusher discards the oldest queued audio
+    BACKPRESSURE_DROP_NEWEST, // the producer discards incoming audio
+    BACKPRESSURE_ADAPTIVE     // pushed periods are shrunk in proportion to the overfill
+};
+
+/**
+ * PipelineEventType - Bus events forwarded to Java (AudioCaptureService.EVENT_*)
+ */
+enum PipelineEventType {
+    EVENT_ERROR = 0,
+    EVENT_WARNING = 1,
+    EVENT_EOS = 2,
+    EVENT_LATENCY = 3,
+    EVENT_QOS = 4,
+    EVENT_DROPPED = 5
+};
+
+/**
+ * StructureOptions - Pipeline options as EncoderConfig::apply_overrides reads them
+ */
+class StructureOptions {
+    private:
+        const GstStructure *structure;
+
+    public:
+        explicit StructureOptions(const GstStructure *structure) : structure(structure) {}
+
+        bool get_int(const char *key, int &value) const {
+            return gst_structure_get_int(structure, key, &value);
+        }
+
+        bool get_uint(const char *key, unsigned &value) const {
+            return gst_structure_get_uint(structure, key, &value);
+        }
+
+        bool get_bool(const char *key, bool &value) const {
+            gboolean flag;
+            if (!gst_structure_get_boolean(structure, key, &flag)) {
+                return false;
+            }
+            value = flag;
+            return true;
+        }
+
+        const char *get_string(const char *key) const {
+            return gst_structure_get_string(structure, key);
+        }
+};
+
+/**
+ * Set opusenc up from an EncoderConfig
+ */
+static void apply_encoder_config(const EncoderConfig &config, GstElement *encoder) {
+    gst_util_set_object_arg(G_OBJECT(encoder), "frame-size", config.frame_size_nick().c_str());
+    gst_util_set_object_arg(G_OBJECT(encoder), "bitrate-type", config.bitrate_type.c_str());
+    gst_util_set_object_arg(G_OBJECT(encoder), "audio-type", config.audio_type.c_str());
+    g_object_set(G_OBJECT(encoder),
+        "complexity", config.complexity,
+        "inband-fec", (gboolean) config.inband_fec,
+        "packet-loss-percentage", config.packet_loss_percentage,
+        "dtx", (gboolean) config.dtx,
+        "max-payload-size", config.max_payload_size,
+        nullptr);
+}
+
+/**
+ * Configure the FEC stage. Both encoders always sit in the chain and
+ * pass packets through untouched when disabled (RED distance 0, ULPFEC
+ * percentage 0), so switching is a property change and never a relink.
+ */
+static void apply_fec_config(const EncoderConfig &config, GstElement *red_encoder, GstElement *fec_encoder) {
+    if (red_encoder) {
+        g_object_set(G_OBJECT(red_encoder), "distance", config.fec == "red" ? config.fec_distance : 0u, nullptr);
+    }
+    if (fec_encoder) {
+        g_object_set(G_OBJECT(fec_encoder),
+            "percentage", config.fec == "ulpfec" ? MIN(config.fec_percentage, 100u) : 0u,
+            "multipacket", (gboolean) (config.fec_distance > 1),
+            nullptr);
+    }
+}
+
+/**
+ * PipelineStats - Counters reported through nativeGetStats
+ * Field order is the order of the returned long[] (AudioCaptureService.STAT_*)
+ */
+struct PipelineStats {
+    guint64 pool_hits = 0;
+    guint64 pool_misses = 0;
+    guint64 pool_growth = 0;
+    guint64 ring_overruns = 0;
+    guint64 ring_underruns = 0;
+    guint64 discontinuities = 0;
+    guint64 dropped_buffers = 0;
+    guint64 dropped_samples = 0;
+    guint64 dropped_duration_ns = 0;
+    guint64 encoder_bitrate = 0;
+    guint64 rtcp_fraction_lost = 0;
+    guint64 rtcp_jitter_us = 0;
+    guint64 nacks_received = 0;
+    guint64 rtx_packets = 0;
+    guint64 rtx_history_misses = 0;
+    guint64 egress_syscalls = 0;
+    guint64 egress_syscalls_per_second = 0;
+    guint64 tcp_clients = 0;
+    guint64 tcp_max_lag_ms = 0;
+    guint64 send_eagain = 0;
+    guint64 send_enobufs = 0;
+    guint64 rtp_packet_rate = 0;
+    guint64 rtp_overhead_permille = 0;
+    gint64 time_to_first_packet_us = -1;
+    gint64 init_create_us = 0;
+    gint64 init_link_us = 0;
+    gint64 init_configure_us = 0;
+    gint64 start_us = 0;
+    gint64 cold_start_us = -1;
+};
+
+/**
+ * CountingBufferPool - GstBufferPool that counts buffer allocations
+ *
+ * Every allocation after activation means the pool had to grow past its
+ * preallocated buffers, which is exactly the allocator traffic the capture
+ * path is trying to avoid, so AudioPipeline reports it.
+ */
+struct CountingBufferPool {
+    GstBufferPool parent;
+    gint allocated;
+};
+
+struct CountingBufferPoolClass {
+    GstBufferPoolClass parent_class;
+};
+
+G_DEFINE_TYPE(CountingBufferPool, counting_buffer_pool, GST_TYPE_BUFFER_POOL)
+
+static GstFlowReturn counting_buffer_pool_alloc_buffer(GstBufferPool *pool, GstBuffer **buffer,
+                                                       GstBufferPoolAcquireParams *params) {
+    g_atomic_int_inc(&reinterpret_cast<CountingBufferPool*>(pool)->allocated);
+    return GST_BUFFER_POOL_CLASS(counting_buffer_pool_parent_class)->alloc_buffer(pool, buffer, params);
+}
+
+static void counting_buffer_pool_class_init(CountingBufferPoolClass *klass) {
+    GST_BUFFER_POOL_CLASS(klass)->alloc_buffer = counting_buffer_pool_alloc_buffer;
+}
+
+static void counting_buffer_pool_init(CountingBufferPool *pool) {
+    pool->allocated = 0;
+}
+
+/**
+ * AudioPipeline - Encapsulates GStreamer pipeline state and operations
+ *
+ * Design follows GStreamer best practices:
+ * - Builds the graph element by element from cached factories
+ * - Proper reference counting with GStreamer objects
+ * - Bus watch for message handling
+ * - Clean state transitions
+ */
+class AudioPipeline {
+    private:
+        GstElement *pipeline = nullptr;
+        GstElement *appsrc = nullptr;
+        GstElement *encoder = nullptr;
+        GstElement *rtpbin = nullptr;
+        GstElement *red_encoder = nullptr;
+        GstElement *fec_encoder = nullptr;
+        GstElement *rtx_sender = nullptr;
+        GstElement *rtp_sink = nullptr;
+        GstElement *rtcp_sink = nullptr;
+
+        // Bus messages are dispatched by a GMainLoop on a context and thread
+        // of our own, and forwarded to Java in batches
+        GMainContext *bus_context = nullptr;
+        GMainLoop *bus_loop = nullptr;
+        GSource *bus_source = nullptr;
+        GSource *flush_source = nullptr;
+        std::thread bus_thread;
+        JNIEnv *bus_env = nullptr;
+        jobject event_listener = nullptr;
+        std::vector<std::pair<gint, std::string>> pending_events;
+        guint dropped_events = 0;
+        std::mutex bus_mutex;
+        std::condition_variable bus_cv;
+        bool eos_seen = false;
+        bool error_seen = false;
+        // Latched by the first stop(), so the destructor doesn't drain again
+        bool stopped = false;
+
+        // Slabs backing the zero-copy direct ByteBuffer feed path
+        std::unique_ptr<DirectBufferPool> direct_pool;
+
+        // Preallocated buffers for the copying feed path
+        GstBufferPool *buffer_pool = nullptr;
+        gint pool_preallocated = 0;
+        std::atomic<guint64> pool_hits{0};
+        std::atomic<guint64> pool_misses{0};
+
+        std::string last_error;
+        std::string pipeline_report;
+        mutable std::mutex error_mutex;
+        bool is_initialized = false;
+
+        // Handle from the session manager, sent along with bus events
+        std::atomic<jlong> session_handle{0};
+
+        // Sessions encoding this pipeline's capture: every period fed here
+        // is copied to them, timestamps included (see add_mirror)
+        std::vector<std::shared_ptr<AudioPipeline>> mirrors;
+        std::mutex mirrors_mutex;
+        std::atomic<bool> has_mirrors{false};
+        std::atomic<bool> is_mirror{false};
+
+        // Capture thread -> pusher thread hand-off
+        std::unique_ptr<SpscRing<GstMiniObject*>> ring;
+        std::thread pusher_thread;
+        std::atomic<bool> pusher_running{false};
+        std::atomic<bool> pusher_waiting{false};
+        std::mutex pusher_mutex;
+        std::condition_variable pusher_cv;
+        std::atomic<guint64> ring_overruns{0};
+        std::atomic<guint64> ring_underruns{0};
+
+        // Backpressure from appsrc
+        BackpressurePolicy backpressure = BACKPRESSURE_DROP_OLDEST;
+        guint64 _max_queue_bytes = 0;
+        std::atomic<bool> appsrc_full{false};
+        std::atomic<bool> producer_waiting{false};
+        std::condition_variable producer_cv;
+        std::atomic<guint64> dropped_buffers{0};
+        std::atomic<guint64> dropped_samples{0};
+        std::atomic<guint64> dropped_duration{0};
+
+        // Timestamping state, only touched from the capture thread
+        GstClockTime ts_anchor = GST_CLOCK_TIME_NONE;
+        guint64 ts_samples = 0;
+        bool ts_discont = true;
+        std::atomic<guint64> discont_count{0};
+
+        // Encoder settings, changed at runtime by set_encoder_profile
+        EncoderConfig encoder_config;
+        std::mutex encoder_mutex;
+        // Init options, so encoder-* overrides outlive a profile switch
+        GstStructure *encoder_options = nullptr;
+
+        // Receivers, all on the same port pair (RTP on _port, RTCP on _port + 1)
+        std::vector<std::string> destinations;
+        gint _port = RTP_PORT;
+        // Where receivers send their RTCP (reports and NACKs) back to
+        gint _rtcp_port = RTCP_PORT;
+        // Warm standby: PAUSED with everything negotiated, and the time from
+        // start or resume to the first RTP packet leaving
+        std::atomic<bool> paused{false};
+        std::atomic<bool> first_packet_pending{false};
+        std::atomic<gint64> first_packet_requested_us{0};
+        std::atomic<gint64> time_to_first_packet_us{-1};
+        // Init and start phases, and init to the very first packet
+        gint64 init_started_us = 0;
+        gint64 init_create_us = 0;
+        gint64 init_link_us = 0;
+        gint64 init_configure_us = 0;
+        gint64 start_us = 0;
+        std::atomic<gint64> cold_start_us{-1};
+
+        std::string multicast_group;
+        // Local ports this session listens on, see bound_ports
+        std::vector<gint> local_ports;
+        bool batched_egress = false;
+        gint _mtu = DEFAULT_RTP_MTU;
+        GstElement *aggregator = nullptr;
+
+        // TCP server clients, tracked for per-client lag
+        GstElement *tcp_server = nullptr;
+        std::vector<GSocket*> tcp_clients;
+        mutable std::mutex tcp_clients_mutex;
+        std::atomic<guint64> tcp_newest_pts{GST_CLOCK_TIME_NONE};
+        std::mutex destinations_mutex;
+
+        // RTCP feedback loop, driven from the RTCP receive thread
+        std::unique_ptr<BitrateController> bitrate_controller;
+        guint32 sender_ssrc = 0;
+        std::atomic<gint> encoder_bitrate{0};
+        std::atomic<guint> rtcp_fraction_lost{0};
+        std::atomic<guint64> rtcp_jitter_us{0};
+        std::atomic<guint64> nacks_received{0};
+
+        // Audio parameters
+        gint _sample_rate = 0;
+        gint _channels = 0;
+        std::string _format;
+        gint _bytes_per_sample = 2;
+        gsize _period_size = 0;
+        guint _max_batch_periods = 1;
+
+        /**
+         * Bus message callback - handles pipeline messages
+         * Runs on the bus thread
+         */
+        static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data) {
+            AudioPipeline *pipeline = static_cast<AudioPipeline*>(data);
+            std::string source = GST_MESSAGE_SRC(msg) ? GST_OBJECT_NAME(GST_MESSAGE_SRC(msg)) : "pipeline";
+
+            switch (GST_MESSAGE_TYPE(msg)) {
+                case GST_MESSAGE_ERROR: {
+                    GError *err = nullptr;
+                    gchar *debug_info = nullptr;
+                    gst_message_parse_error(msg, &err, &debug_info);
+
+                    pipeline->set_error(std::string("GStreamer error: ") + err->message);
+                    LOGE("Pipeline error from %s: %s", source.c_str(), err->message);
+                    LOGE("Debug info: %s", debug_info ? debug_info : "none");
+                    pipeline->signal_bus(false);
+
+                    // Errors go out right away, with whatever was queued before
+                    pipeline->queue_event(EVENT_ERROR, source + ": " + err->message);
+                    pipeline->flush_events();
+
+                    g_clear_error(&err);
+                    g_free(debug_info);
+                    break;
+                }
+
+                case GST_MESSAGE_WARNING: {
+                    GError *err = nullptr;
+                    gchar *debug_info = nullptr;
+                    gst_message_parse_warning(msg, &err, &debug_info);
+
+                    LOGW("Pipeline warning from %s: %s", source.c_str(), err->message);
+                    pipeline->queue_event(EVENT_WARNING, source + ": " + err->message);
+
+                    g_clear_error(&err);
+                    g_free(debug_info);
+                    break;
+                }
+
+                case GST_MESSAGE_EOS:
+                    LOGI("End-of-stream reached");
+                    pipeline->signal_bus(true);
+                    pipeline->queue_event(EVENT_EOS, "End of stream");
+                    break;
+
+                case GST_MESSAGE_LATENCY:
+                    pipeline->recalculate_latency();
+                    break;
+
+                case GST_MESSAGE_QOS: {
+                    GstFormat format = GST_FORMAT_UNDEFINED;
+                    guint64 processed = 0;
+                    guint64 dropped = 0;
+                    gst_message_parse_qos_stats(msg, &format, &processed, &dropped);
+                    pipeline->queue_event(EVENT_QOS, source + ": " + std::to_string(dropped) + " dropped, " +
+                                          std::to_string(processed) + " processed");
+                    break;
+                }
+
+                case GST_MESSAGE_STATE_CHANGED:
+                    if (GST_MESSAGE_SRC(msg) == GST_OBJECT(pipeline->pipeline)) {
+                        GstState old_state, new_state, pending_state;
+                        gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
+                        LOGD("Pipeline state: %s -> %s",
+                             gst_element_state_get_name(old_state),
+                             gst_element_state_get_name(new_state));
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+
+            return TRUE;
+        }
+
+        /**
+         * Wake stop() on EOS or error
+         */
+        void signal_bus(bool eos) {
+            {
+                std::lock_guard<std::mutex> lock(bus_mutex);
+                if (eos) {
+                    eos_seen = true;
+                } else {
+                    error_seen = true;
+                }
+            }
+            bus_cv.notify_all();
+        }
+
+        /**
+         * Some element's latency changed: redistribute it and report what
+         * the pipeline adds now
+         */
+        void recalculate_latency() {
+            gst_bin_recalculate_latency(GST_BIN(pipeline));
+
+            std::string message = "Latency changed";
+            GstQuery *query = gst_query_new_latency();
+            if (gst_element_query(pipeline, query)) {
+                gboolean live = FALSE;
+                GstClockTime min_latency = 0;
+                GstClockTime max_latency = 0;
+                gst_query_parse_latency(query, &live, &min_latency, &max_latency);
+                if (GST_CLOCK_TIME_IS_VALID(min_latency)) {
+                    message = "Pipeline latency " + std::to_string(min_latency / GST_USECOND) + "us";
+                }
+            }
+            gst_query_unref(query);
+
+            LOGI("%s", message.c_str());
+            queue_event(EVENT_LATENCY, message);
+        }
+
+        /**
+         * Queue an event for Java, bus thread only. Queued events go out
+         * together EVENT_BATCH_MS after the first one.
+         */
+        void queue_event(gint type, const std::string &message) {
+            if (pending_events.size() >= MAX_PENDING_EVENTS) {
+                // Errors and EOS always go out: they take the place of the
+                // oldest informational event, or go over the cap
+                if (type != EVENT_ERROR && type != EVENT_EOS) {
+                    dropped_events++;
+                    return;
+                }
+
+                auto oldest = std::find_if(pending_events.begin(), pending_events.end(),
+                    [](const std::pair<gint, std::string> &event) {
+                        return event.first != EVENT_ERROR && event.first != EVENT_EOS;
+                    });
+                if (oldest != pending_events.end()) {
+                    pending_events.erase(oldest);
+                    dropped_events++;
+                }
+            }
+
+            pending_events.emplace_back(type, message);
+            if (!flush_source) {
+                flush_source = g_timeout_source_new(EVENT_BATCH_MS);
+                g_source_set_callback(flush_source, on_flush_events, this, nullptr);
+                g_source_attach(flush_source, bus_context);
+            }
+        }
+
+        static gboolean on_flush_events(gpointer data) {
+            static_cast<AudioPipeline*>(data)->flush_events();
+            return G_SOURCE_REMOVE;
+        }
+
+        /**
+         * Hand queued events to AudioCaptureService.onPipelineEvents in one
+         * call, bus thread only
+         */
+        void flush_events() {
+            if (flush_source) {
+                g_source_destroy(flush_source);
+                g_source_unref(flush_source);
+                flush_source = nullptr;
+            }
+            if (pending_events.empty()) {
+                return;
+            }
+            if (dropped_events > 0) {
+                LOGW("%u pipeline events dropped, Java is not keeping up", dropped_events);
+                pending_events.emplace_back(EVENT_DROPPED, std::to_string(dropped_events) + " events dropped");
+                dropped_events = 0;
+            }
+
+            JNIEnv *env = bus_env;
+            if (env && event_listener && g_on_pipeline_events) {
+                jsize count = (jsize) pending_events.size();
+                jintArray types = env->NewIntArray(count);
+                jobjectArray messages = env->NewObjectArray(count, g_string_class, nullptr);
+
+                if (types && messages) {
+                    for (jsize i = 0; i < count; i++) {
+                        jint type = pending_events[i].first;
+                        env->SetIntArrayRegion(types, i, 1, &type);
+                        jstring message = env->NewStringUTF(pending_events[i].second.c_str());
+                        env->SetObjectArrayElement(messages, i, message);
+                        env->DeleteLocalRef(message);
+                    }
+                    env->CallVoidMethod(event_listener, g_on_pipeline_events, session_handle.load(), types, messages);
+                }
+
+                if (env->ExceptionCheck()) {
+                    env->ExceptionDescribe();
+                    env->ExceptionClear();
+                }
+                if (types) {
+                    env->DeleteLocalRef(types);
+                }
+                if (messages) {
+                    env->DeleteLocalRef(messages);
+                }
+            }
+
+            pending_events.clear();
+        }
+
+        /**
+         * Bus thread body: runs the bus context until cleanup quits it,
+         * attached to the VM so events can be delivered
+         */
+        void run_bus_loop() {
+            pthread_setname_np(pthread_self(), "pipeline-bus");
+            if (!g_jvm || g_jvm->AttachCurrentThread(&bus_env, nullptr) != JNI_OK) {
+                LOGW("Bus thread not attached to the VM, events stay native");
+                bus_env = nullptr;
+            }
+
+            g_main_context_push_thread_default(bus_context);
+            g_main_loop_run(bus_loop);
+
+            // Whatever arrived before the quit still goes out
+            flush_events();
+            g_main_context_pop_thread_default(bus_context);
+
+            if (bus_env) {
+                g_jvm->DetachCurrentThread();
+                bus_env = nullptr;
+            }
+        }
+
+        void start_bus_thread(JNIEnv *env, jobject listener) {
+            if (env && listener) {
+                event_listener = env->NewGlobalRef(listener);
+            }
+
+            eos_seen = false;
+            error_seen = false;
+            bus_context = g_main_context_new();
+            bus_loop = g_main_loop_new(bus_context, FALSE);
+
+            GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
+            bus_source = gst_bus_create_watch(bus);
+            gst_object_unref(bus);
+            g_source_set_callback(bus_source, reinterpret_cast<GSourceFunc>(bus_callback), this, nullptr);
+            g_source_attach(bus_source, bus_context);
+
+            bus_thread = std::thread(&AudioPipeline::run_bus_loop, this);
+        }
+
+        void stop_bus_thread() {
+            if (bus_thread.joinable()) {
+                // Quit from inside the loop, so a quit racing the thread's
+                // start can't be lost
+                GSource *quit = g_idle_source_new();
+                g_source_set_callback(quit, [](gpointer loop) -> gboolean {
+                    g_main_loop_quit(static_cast<GMainLoop*>(loop));
+                    return G_SOURCE_REMOVE;
+                }, bus_loop, nullptr);
+                g_source_attach(quit, bus_context);
+                g_source_unref(quit);
+                bus_thread.join();
+            }
+
+            if (bus_source) {
+                g_source_destroy(bus_source);
+                g_source_unref(bus_source);
+                bus_source = nullptr;
+            }
+            if (bus_loop) {
+                g_main_loop_unref(bus_loop);
+                bus_loop = nullptr;
+            }
+            if (bus_context) {
+                g_main_context_unref(bus_context);
+                bus_context = nullptr;
+            }
+
+            if (event_listener) {
+                JNIEnv *env = nullptr;
+                if (g_jvm) {
+                    g_jvm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6);
+                }
+                if (env) {
+                    env->DeleteGlobalRef(event_listener);
+                }
+                event_listener = nullptr;
+            }
+        }
+
+        /**
+         * Record an error - may be called from the pusher thread
+         */
+        void set_error(const std::string &error) {
+            LOGE("%s", error.c_str());
+            std::lock_guard<std::mutex> lock(error_mutex);
+            last_error = error;
+        }
+
+        /**
+         * Bytes per interleaved frame of the appsrc format
+         */
+        gint frame_size() const {
+            return _channels * _bytes_per_sample;
+        }
+
+        /**
+         * Number of buffers the pool has allocated so far
+         */
+        gint pool_allocations() const {
+            return buffer_pool ?
+                g_atomic_int_get(&reinterpret_cast<CountingBufferPool*>(buffer_pool)->allocated) : 0;
+        }
+
+        /**
+         * Create the push_data buffer pool
+         *
+         * Buffers are one period large. Enough of them are preallocated to hold
+         * BUFFER_POOL_PREALLOC_MS of audio, and the pool may grow up to what
+         * the appsrc queue can hold before it is full.
+         */
+        bool setup_buffer_pool(GstCaps *caps, guint64 max_queue_bytes) {
+            gint bytes_per_second = _sample_rate * frame_size();
+            if (_period_size == 0 || bytes_per_second <= 0) {
+                return false;
+            }
+
+            guint64 prealloc_bytes = (guint64) bytes_per_second * BUFFER_POOL_PREALLOC_MS / 1000;
+            guint min_buffers = (guint) MAX((prealloc_bytes + _period_size - 1) / _period_size, 4);
+            guint max_buffers = (guint) MAX(max_queue_bytes / _period_size + 4, min_buffers);
+
+            buffer_pool = GST_BUFFER_POOL(g_object_new(counting_buffer_pool_get_type(), nullptr));
+            gst_object_ref_sink(buffer_pool);
+
+            GstStructure *config = gst_buffer_pool_get_config(buffer_pool);
+            gst_buffer_pool_config_set_params(config, caps, (guint) _period_size, min_buffers, max_buffers);
+
+            if (!gst_buffer_pool_set_config(buffer_pool, config) ||
+                !gst_buffer_pool_set_active(buffer_pool, TRUE)) {
+                gst_object_unref(buffer_pool);
+                buffer_pool = nullptr;
+                return false;
+            }
+
+            // Whatever was allocated during activation is the preallocation
+            pool_preallocated = pool_allocations();
+
+            LOGI("Buffer pool ready: %u-%u buffers of %zu bytes", min_buffers, max_buffers, _period_size);
+            return true;
+        }
+
+        /**
+         * Get a writable buffer of the requested size
+         * Served from the pool when possible, heap allocated otherwise
+         */
+        GstBuffer *acquire_buffer(gsize size) {
+            if (buffer_pool && size <= _period_size) {
+                GstBuffer *buffer = nullptr;
+                gint allocated = pool_allocations();
+
+                GstBufferPoolAcquireParams params = {};
+                params.flags = GST_BUFFER_POOL_ACQUIRE_FLAG_DONTWAIT;
+
+                if (gst_buffer_pool_acquire_buffer(buffer_pool, &buffer, &params) == GST_FLOW_OK) {
+                    // Growing the pool counts as a miss even though it succeeded
+                    if (pool_allocations() != allocated) {
+                        pool_misses++;
+                    } else {
+                        pool_hits++;
+                    }
+
+                    gst_buffer_set_size(buffer, size);
+                    return buffer;
+                }
+            }
+
+            pool_misses++;
+            return gst_buffer_new_allocate(nullptr, size, nullptr);
+        }
+
+        /**
+         * Duration of one capture period
+         */
+        std::chrono::nanoseconds period_duration() const {
+            gint bytes_per_second = _sample_rate * frame_size();
+            if (_period_size == 0 || bytes_per_second <= 0) {
+                return std::chrono::milliseconds(10);
+            }
+            return std::chrono::nanoseconds(
+                gst_util_uint64_scale(_period_size, GST_SECOND, bytes_per_second));
+        }
+
+        /**
+         * Size the ring to hold capacity_ms of audio in whole feeds
+         * (a batched feed occupies one slot for all of its periods)
+         */
+        void setup_ring(gint capacity_ms) {
+            gint bytes_per_second = _sample_rate * frame_size();
+            size_t slots = ring_slots((guint64) MAX(bytes_per_second, 0),
+                                      _period_size * _max_batch_periods, capacity_ms);
+
+            ring = std::make_unique<SpscRing<GstMiniObject*>>(slots);
+            LOGI("Ring ready: %zu feeds of %u period(s) (%dms)", slots, _max_batch_periods, capacity_ms);
+        }
+
+        /**
+         * appsrc queue callbacks - track whether appsrc is above max-bytes
+         */
+        static void on_need_data(GstAppSrc *src, guint length, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            if (self->appsrc_full.exchange(false)) {
+                std::lock_guard<std::mutex> lock(self->pusher_mutex);
+                self->pusher_cv.notify_one();
+            }
+        }
+
+        static void on_enough_data(GstAppSrc *src, gpointer data) {
+            static_cast<AudioPipeline*>(data)->appsrc_full.store(true);
+        }
+
+        static BackpressurePolicy parse_backpressure(const gchar *name) {
+            if (!g_strcmp0(name, "block")) {
+                return BACKPRESSURE_BLOCK;
+            } else if (!g_strcmp0(name, "drop-newest")) {
+                return BACKPRESSURE_DROP_NEWEST;
+            } else if (!g_strcmp0(name, "adaptive")) {
+                return BACKPRESSURE_ADAPTIVE;
+            }
+            return BACKPRESSURE_DROP_OLDEST;
+        }
+
+        /**
+         * Count audio that is about to be discarded
+         */
+        void account_drop(GstBuffer *buffer) {
+            dropped_buffers++;
+            dropped_samples += gst_buffer_get_size(buffer) / frame_size();
+            if (GST_BUFFER_DURATION_IS_VALID(buffer)) {
+                dropped_duration += GST_BUFFER_DURATION(buffer);
+            }
+        }
+
+        void account_drop(GstMiniObject *item) {
+            if (GST_IS_BUFFER_LIST(item)) {
+                GstBufferList *list = GST_BUFFER_LIST_CAST(item);
+                for (guint i = 0; i < gst_buffer_list_length(list); i++) {
+                    account_drop(gst_buffer_list_get(list, i));
+                }
+            } else {
+                account_drop(GST_BUFFER_CAST(item));
+            }
+        }
+
+        /**
+         * Adaptive policy: cut the oldest fraction of a buffer
+         *
+         * Returns false when nothing is left of the buffer. The remaining part
+         * keeps exact timestamps and is marked DISCONT.
+         */
+        bool shrink_buffer(GstBuffer *buffer, gdouble fraction) {
+            gsize size = gst_buffer_get_size(buffer);
+            guint64 samples = size / frame_size();
+            guint64 cut = (guint64) (samples * fraction);
+
+            if (cut == 0) {
+                return true;
+            }
+            if (cut >= samples) {
+                account_drop(buffer);
+                return false;
+            }
+
+            GstClockTime cut_duration = gst_util_uint64_scale(cut, GST_SECOND, _sample_rate);
+            dropped_samples += cut;
+            dropped_duration += cut_duration;
+
+            gst_buffer_resize(buffer, cut * frame_size(), size - cut * frame_size());
+            GST_BUFFER_PTS(buffer) += cut_duration;
+            GST_BUFFER_DURATION(buffer) -= MIN(cut_duration, GST_BUFFER_DURATION(buffer));
+            GST_BUFFER_OFFSET(buffer) += cut;
+            GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
+            return true;
+        }
+
+        /**
+         * Adaptive policy: shrink what is pushed in proportion to how far the
+         * appsrc queue is above max-bytes. At twice max-bytes everything is
+         * dropped, which bounds memory.
+         */
+        GstMiniObject *shrink_item(GstMiniObject *item) {
+            guint64 level = gst_app_src_get_current_level_bytes(GST_APP_SRC(appsrc));
+            if (_max_queue_bytes == 0 || level <= _max_queue_bytes) {
+                return item;
+            }
+
+            gdouble fraction = MIN((gdouble) (level - _max_queue_bytes) / _max_queue_bytes, 1.0);
+
+            if (GST_IS_BUFFER_LIST(item)) {
+                GstBufferList *list = GST_BUFFER_LIST_CAST(item);
+                for (guint i = 0; i < gst_buffer_list_length(list);) {
+                    if (shrink_buffer(gst_buffer_list_get_writable(list, i), fraction)) {
+                        i++;
+                    } else {
+                        gst_buffer_list_remove(list, i, 1);
+                    }
+                }
+                if (gst_buffer_list_length(list) > 0) {
+                    return item;
+                }
+            } else if (shrink_buffer(GST_BUFFER_CAST(item), fraction)) {
+                return item;
+            }
+
+            gst_mini_object_unref(item);
+            return nullptr;
+        }
+
+        /**
+         * Whether the pusher may hand the next item to appsrc
+         */
+        bool can_push() const {
+            return backpressure == BACKPRESSURE_BLOCK ||
+                   backpressure == BACKPRESSURE_ADAPTIVE ||
+                   !appsrc_full.load();
+        }
+
+        /**
+         * Drop-oldest policy: make room before the producer finds the ring full
+         */
+        bool should_drop_oldest() const {
+            return backpressure == BACKPRESSURE_DROP_OLDEST &&
+                   appsrc_full.load() &&
+                   ring->size() + 1 >= ring->capacity();
+        }
+
+        /**
+         * Pusher thread - drains the ring into appsrc so a blocking push
+         * never delays the next AudioRecord.read
+         */
+        void pusher_loop() {
+            pthread_setname_np(pthread_self(), "hw-pusher");
+
+            // Waiting longer than two periods means capture fell behind
+            auto underrun_timeout = period_duration() * 2;
+            bool had_data = false;
+
+            // The capture thread only counts overruns; they are reported here
+            guint64 reported_overruns = ring_overruns.load();
+            gint64 last_report_us = 0;
+
+            while (true) {
+                GstMiniObject *item = nullptr;
+                bool running = pusher_running.load();
+
+                guint64 overruns = ring_overruns.load();
+                if (overruns != reported_overruns) {
+                    gint64 now_us = g_get_monotonic_time();
+                    if (now_us - last_report_us >= OVERRUN_REPORT_INTERVAL_MS * 1000) {
+                        set_error("Ring overrun, " + std::to_string(overruns - reported_overruns) + " period(s) dropped");
+                        reported_overruns = overruns;
+                        last_report_us = now_us;
+                    }
+                }
+
+                // On shutdown everything queued is pushed regardless of policy
+                if (can_push() || !running) {
+                    if (ring->pop(item)) {
+                        had_data = true;
+                        notify_producer();
+
+                        if (backpressure == BACKPRESSURE_ADAPTIVE) {
+                            item = shrink_item(item);
+                        }
+                        if (item) {
+                            push_item(item);
+                        }
+                        continue;
+                    }
+
+                    // Only exit once the ring has been drained
+                    if (!running) {
+                        break;
+                    }
+                } else if (should_drop_oldest() && ring->pop(item)) {
+                    notify_producer();
+                    account_drop(item);
+                    gst_mini_object_unref(item);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(pusher_mutex);
+                pusher_waiting.store(true);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                bool woke = pusher_cv.wait_for(lock, underrun_timeout, [this] {
+                    return (!ring->empty() && can_push()) || should_drop_oldest() ||
+                           !pusher_running.load();
+                });
+                pusher_waiting.store(false);
+
+                // Count each starvation episode once
+                if (!woke && had_data && ring->empty()) {
+                    ring_underruns++;
+                    had_data = false;
+                }
+            }
+        }
+
+        /**
+         * Wake a producer blocked on a full ring (block policy)
+         */
+        void notify_producer() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (producer_waiting.load()) {
+                std::lock_guard<std::mutex> lock(pusher_mutex);
+                producer_cv.notify_one();
+            }
+        }
+
+        void start_pusher() {
+            if (!ring || pusher_thread.joinable()) {
+                return;
+            }
+
+            pusher_running.store(true);
+            pusher_thread = std::thread(&AudioPipeline::pusher_loop, this);
+        }
+
+        /**
+         * Stop the pusher thread after it has drained the ring
+         */
+        void stop_pusher() {
+            if (!pusher_thread.joinable()) {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(pusher_mutex);
+                pusher_running.store(false);
+            }
+            pusher_cv.notify_one();
+            producer_cv.notify_all();
+            pusher_thread.join();
+        }
+
+        /**
+         * Current running time of the pipeline, or GST_CLOCK_TIME_NONE when
+         * it has no clock yet (not PLAYING)
+         */
+        GstClockTime running_time_now() const {
+            GstClock *clock = gst_element_get_clock(pipeline);
+            if (!clock) {
+                return GST_CLOCK_TIME_NONE;
+            }
+
+            GstClockTime now = gst_clock_get_time(clock);
+            GstClockTime base_time = gst_element_get_base_time(pipeline);
+            gst_object_unref(clock);
+
+            return now > base_time ? now - base_time : 0;
+        }
+
+        /**
+         * Stamp PTS and duration from the running sample counter
+         *
+         * The counter is anchored to the pipeline clock at the first push, so
+         * timestamps advance exactly with the audio and never jitter with
+         * scheduling. When the clock gets more than DISCONT_THRESHOLD_MS
+         * ahead of the counter, capture has skipped: the counter jumps
+         * forward to the clock and the buffer is marked DISCONT.
+         */
+        void stamp_buffer(GstBuffer *buffer) {
+            guint64 samples = gst_buffer_get_size(buffer) / frame_size();
+            GstClockTime duration = gst_util_uint64_scale(samples, GST_SECOND, _sample_rate);
+            GstClockTime now = running_time_now();
+
+            if (!GST_CLOCK_TIME_IS_VALID(ts_anchor)) {
+                // The first sample was captured one buffer duration ago
+                ts_anchor = GST_CLOCK_TIME_IS_VALID(now) && now > duration ? now - duration : 0;
+                ts_samples = 0;
+                ts_discont = true;
+            } else if (GST_CLOCK_TIME_IS_VALID(now)) {
+                GstClockTime expected_end = ts_anchor +
+                    gst_util_uint64_scale(ts_samples + samples, GST_SECOND, _sample_rate);
+
+                if (now > expected_end + DISCONT_THRESHOLD_MS * GST_MSECOND) {
+                    guint64 skipped = gst_util_uint64_scale(now - expected_end, _sample_rate, GST_SECOND);
+                    LOGW("Capture skipped %" G_GUINT64_FORMAT " samples, marking discontinuity", skipped);
+                    ts_samples += skipped;
+                    ts_discont = true;
+                }
+            }
+
+            GstClockTime pts = ts_anchor + gst_util_uint64_scale(ts_samples, GST_SECOND, _sample_rate);
+            GstClockTime end = ts_anchor + gst_util_uint64_scale(ts_samples + samples, GST_SECOND, _sample_rate);
+
+            GST_BUFFER_PTS(buffer) = pts;
+            GST_BUFFER_DURATION(buffer) = end - pts;
+            GST_BUFFER_OFFSET(buffer) = ts_samples;
+            GST_BUFFER_OFFSET_END(buffer) = ts_samples + samples;
+
+            if (ts_discont) {
+                GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DISCONT);
+                discont_count++;
+                ts_discont = false;
+            }
+
+            ts_samples += samples;
+        }
+
+        /**
+         * Hand a filled buffer to the pusher thread
+         */
+        bool queue_buffer(GstBuffer *buffer) {
+            stamp_buffer(buffer);
+            feed_mirrors(GST_MINI_OBJECT_CAST(buffer));
+            return enqueue(GST_MINI_OBJECT_CAST(buffer));
+        }
+
+        /**
+         * Hand a list of consecutive periods to the pusher thread
+         * Each buffer gets its own timestamps from the sample counter
+         */
+        bool queue_buffer_list(GstBufferList *list) {
+            guint length = gst_buffer_list_length(list);
+            for (guint i = 0; i < length; i++) {
+                stamp_buffer(gst_buffer_list_get_writable(list, i));
+            }
+            feed_mirrors(GST_MINI_OBJECT_CAST(list));
+            return enqueue(GST_MINI_OBJECT_CAST(list));
+        }
+
+        /**
+         * Hand a copy of a stamped buffer or list to every mirror session
+         * Capture thread only. Mirrors run on the same clock and base time,
+         * so the timestamps are valid there as they are.
+         */
+        void feed_mirrors(GstMiniObject *item) {
+            if (!has_mirrors.load()) {
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(mirrors_mutex);
+            for (const std::shared_ptr<AudioPipeline> &mirror : mirrors) {
+                if (!mirror->is_initialized || !mirror->appsrc) {
+                    continue;
+                }
+
+                GstMiniObject *copy = nullptr;
+                if (GST_IS_BUFFER_LIST(item)) {
+                    GstBufferList *list = GST_BUFFER_LIST_CAST(item);
+                    guint length = gst_buffer_list_length(list);
+                    GstBufferList *mirror_list = gst_buffer_list_new_sized(length);
+                    for (guint i = 0; i < length; i++) {
+                        GstBuffer *buffer = mirror->mirror_buffer(gst_buffer_list_get(list, i));
+                        if (buffer) {
+                            gst_buffer_list_add(mirror_list, buffer);
+                        }
+                    }
+                    copy = GST_MINI_OBJECT_CAST(mirror_list);
+                } else {
+                    copy = GST_MINI_OBJECT_CAST(mirror->mirror_buffer(GST_BUFFER_CAST(item)));
+                }
+
+                if (copy) {
+                    mirror->enqueue_mirror(copy);
+                }
+            }
+        }
+
+        /**
+         * Mirror side of enqueue, called on the other session's capture
+         * thread: never waits, whatever the backpressure policy, so a stalled
+         * mirror can't hold up the session feeding it
+         */
+        bool enqueue_mirror(GstMiniObject *item) {
+            if (!pusher_running.load() || !ring->push(item)) {
+                ring_overruns++;
+                account_drop(item);
+                gst_mini_object_unref(item);
+                return false;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (pusher_waiting.load()) {
+                std::lock_guard<std::mutex> lock(pusher_mutex);
+                pusher_cv.notify_one();
+            }
+
+            return true;
+        }
+
+        /**
+         * Copy a buffer from the session this one mirrors into our own pool
+         * Slab memory isn't shared: the slabs go away with the other pipeline.
+         */
+        GstBuffer *mirror_buffer(GstBuffer *source) {
+            GstMapInfo map;
+            if (!gst_buffer_map(source, &map, GST_MAP_READ)) {
+                return nullptr;
+            }
+
+            GstBuffer *buffer = copy_to_buffer(map.data, map.size);
+            gst_buffer_unmap(source, &map);
+            if (buffer) {
+                gst_buffer_copy_into(buffer, source,
+                    (GstBufferCopyFlags) (GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS), 0, -1);
+            }
+            return buffer;
+        }
+
+        /**
+         * Constant time on the capture thread; drops the item when the ring
+         * is full rather than waiting. Drops are only counted here, the
+         * pusher reports them.
+         */
+        bool enqueue(GstMiniObject *item) {
+            if (!pusher_running.load()) {
+                return push_item(item);
+            }
+
+            if (!ring->push(item) && !(backpressure == BACKPRESSURE_BLOCK && wait_and_push(item))) {
+                // The sample counter already moved past this audio, so the
+                // next buffer follows a gap
+                ring_overruns++;
+                ts_discont = true;
+                account_drop(item);
+                gst_mini_object_unref(item);
+                return false;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (pusher_waiting.load()) {
+                std::lock_guard<std::mutex> lock(pusher_mutex);
+                pusher_cv.notify_one();
+            }
+
+            return true;
+        }
+
+        /**
+         * Block policy: wait for the pusher to free a slot
+         * Bounded by the ring's own capacity so a wedged pipeline can't hold
+         * the capture thread forever
+         */
+        bool wait_and_push(GstMiniObject *item) {
+            auto deadline = std::chrono::steady_clock::now() + period_duration() * ring->capacity();
+
+            std::unique_lock<std::mutex> lock(pusher_mutex);
+            producer_waiting.store(true);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            bool pushed = false;
+            while (!(pushed = ring->push(item)) && pusher_running.load()) {
+                if (producer_cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+                    pushed = ring->push(item);
+                    break;
+                }
+            }
+            producer_waiting.store(false);
+
+            if (pushed) {
+                pusher_cv.notify_one();
+            }
+            return pushed;
+        }
+
+        /**
+         * Fill a pooled buffer with a copy of the data
+         */
+        GstBuffer *copy_to_buffer(const guint8 *data, gsize size) {
+            GstBuffer *buffer = acquire_buffer(size);
+            if (!buffer) {
+                LOGE("Failed to allocate buffer");
+                return nullptr;
+            }
+
+            // Map and fill buffer
+            GstMapInfo map;
+            if (!gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+                LOGE("Failed to map buffer");
+                gst_buffer_unref(buffer);
+                return nullptr;
+            }
+
+            memcpy(map.data, data, size);
+            gst_buffer_unmap(buffer, &map);
+            return buffer;
+        }
+
+        /**
+         * Whether the input caps can reach the encoder once the given fields
+         * are left to a converter
+         */
+        static bool caps_match_except(const GstCaps *input, const GstCaps *accepted,
+                                      std::initializer_list<const char*> fields) {
+            GstCaps *reduced = gst_caps_copy(input);
+            GstStructure *structure = gst_caps_get_structure(reduced, 0);
+            for (const char *field : fields) {
+                gst_structure_remove_field(structure, field);
+            }
+
+            bool match = gst_caps_can_intersect(reduced, accepted);
+            gst_caps_unref(reduced);
+            return match;
+        }
+
+        /**
+         * Pick the conversion elements the input needs in front of the encoder
+         *
+         * The input caps are checked against the encoder factory's sink pad
+         * template: audioconvert is only inserted for a format, layout or
+         * channel mismatch and audioresample only for a rate mismatch. When
+         * the factory can't be inspected both are kept, as before.
+         * Returns the converter factory names in link order.
+         */
+        std::vector<const char*> plan_conversion(const GstCaps *input, const char *encoder) {
+            GstElementFactory *factory = ElementFactoryCache::get(encoder);
+            GstCaps *accepted = nullptr;
+
+            if (factory) {
+                for (const GList *l = gst_element_factory_get_static_pad_templates(factory); l; l = l->next) {
+                    GstStaticPadTemplate *templ = static_cast<GstStaticPadTemplate*>(l->data);
+                    if (templ->direction == GST_PAD_SINK) {
+                        accepted = gst_static_pad_template_get_caps(templ);
+                        break;
+                    }
+                }
+            }
+
+            bool needs_convert = true;
+            bool needs_resample = true;
+            const char *reason = "encoder caps unknown";
+
+            if (accepted) {
+                if (gst_caps_can_intersect(input, accepted)) {
+                    needs_convert = false;
+                    needs_resample = false;
+                    reason = "input matches encoder caps";
+                } else {
+                    needs_convert = !caps_match_except(input, accepted, {"rate"});
+                    needs_resample = !caps_match_except(input, accepted,
+                        {"format", "layout", "channels", "channel-mask"});
+                    reason = "input differs from encoder caps";
+                }
+                gst_caps_unref(accepted);
+            }
+
+            std::vector<const char*> chain;
+            std::string path;
+            if (needs_convert) {
+                chain.push_back("audioconvert");
+            }
+            if (needs_resample) {
+                chain.push_back("audioresample");
+            }
+            for (const char *name : chain) {
+                path += path.empty() ? name : std::string(" ! ") + name;
+            }
+
+            gchar *input_str = gst_caps_to_string(input);
+            pipeline_report = std::string("input ") + input_str + " -> " +
+                (path.empty() ? "direct" : path) +
+                " -> " + encoder + " (" + reason + ")";
+            g_free(input_str);
+
+            LOGI("Pipeline path: %s", pipeline_report.c_str());
+            return chain;
+        }
+
+        /**
+         * Incoming RTCP on the sending session - picks out the report blocks
+         * receivers sent about our stream
+         */
+        static void on_receiving_rtcp(GObject *session, GstBuffer *buffer, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            GstRTCPBuffer rtcp = GST_RTCP_BUFFER_INIT;
+
+            if (!gst_rtcp_buffer_map(buffer, GST_MAP_READ, &rtcp)) {
+                return;
+            }
+
+            GstRTCPPacket packet;
+            gboolean more = gst_rtcp_buffer_get_first_packet(&rtcp, &packet);
+
+            while (more) {
+                GstRTCPType type = gst_rtcp_packet_get_type(&packet);
+
+                if (type == GST_RTCP_TYPE_RR || type == GST_RTCP_TYPE_SR) {
+                    for (guint i = 0; i < gst_rtcp_packet_get_rb_count(&packet); i++) {
+                        guint32 ssrc, exthighestseq, jitter, lsr, dlsr;
+                        guint8 fraction_lost;
+                        gint32 packets_lost;
+
+                        gst_rtcp_packet_get_rb(&packet, i, &ssrc, &fraction_lost, &packets_lost,
+                                               &exthighestseq, &jitter, &lsr, &dlsr);
+                        if (ssrc == self->sender_ssrc) {
+                            self->on_receiver_report(fraction_lost, jitter);
+                        }
+                    }
+                } else if (type == GST_RTCP_TYPE_RTPFB &&
+                           gst_rtcp_packet_fb_get_type(&packet) == GST_RTCP_RTPFB_TYPE_NACK &&
+                           gst_rtcp_packet_fb_get_media_ssrc(&packet) == self->sender_ssrc) {
+                    // Each FCI word is one NACK entry; the session turns them
+                    // into retransmission requests for rtprtxsend
+                    self->nacks_received.fetch_add(gst_rtcp_packet_fb_get_fci_length(&packet));
+                }
+
+                more = gst_rtcp_packet_move_to_next(&packet);
+            }
+
+            gst_rtcp_buffer_unmap(&rtcp);
+        }
+
+        /**
+         * One receiver report block about our stream
+         */
+        void on_receiver_report(guint8 fraction_lost, guint32 jitter) {
+            // Jitter is in RTP timestamp units; Opus RTP always runs at 48 kHz
+            guint64 jitter_us = gst_util_uint64_scale(jitter, G_USEC_PER_SEC, 48000);
+
+            rtcp_fraction_lost.store(fraction_lost);
+            rtcp_jitter_us.store(jitter_us);
+
+            // set_encoder_profile reads the controller and sets the encoder too
+            std::lock_guard<std::mutex> lock(encoder_mutex);
+            if (!bitrate_controller || !bitrate_controller->on_report(fraction_lost, jitter_us / 1000.0)) {
+                return;
+            }
+
+            gint bitrate = bitrate_controller->get_bitrate();
+            gint loss_percentage = bitrate_controller->get_loss_percentage();
+
+            LOGI("Receiver report: %.1f%% loss, %.1fms jitter -> %dbps, packet-loss-percentage=%d",
+                 fraction_lost * 100.0 / 256.0, jitter_us / 1000.0, bitrate, loss_percentage);
+
+            g_object_set(G_OBJECT(encoder),
+                "bitrate", bitrate,
+                "packet-loss-percentage", loss_percentage,
+                nullptr);
+            encoder_bitrate.store(bitrate);
+        }
+
+        /**
+         * Hook the bitrate controller up to the sending RTP session
+         */
+        bool setup_rtcp_feedback(gint bitrate, const GstStructure *options) {
+            GstElement *payloader = gst_bin_get_by_name(GST_BIN(pipeline), "payloader");
+            if (!payloader) {
+                return false;
+            }
+
+            // A known SSRC lets us find our stream in receiver reports
+            sender_ssrc = g_random_int();
+            g_object_set(G_OBJECT(payloader), "ssrc", sender_ssrc, nullptr);
+            gst_object_unref(payloader);
+
+            GObject *session = nullptr;
+            g_signal_emit_by_name(rtpbin, "get-internal-session", 0, &session);
+            if (!session) {
+                return false;
+            }
+            g_signal_connect(session, "on-receiving-rtcp", G_CALLBACK(on_receiving_rtcp), this);
+            g_object_unref(session);
+
+            gboolean abr = TRUE;
+            gint min_bitrate = 24000;
+            gint max_bitrate = bitrate;
+            if (options) {
+                gst_structure_get_boolean(options, "abr", &abr);
+                gst_structure_get_int(options, "abr-min-bitrate", &min_bitrate);
+                gst_structure_get_int(options, "abr-max-bitrate", &max_bitrate);
+            }
+
+            encoder_bitrate.store(bitrate);
+            if (abr) {
+                bitrate_controller = std::make_unique<BitrateController>(min_bitrate, MIN(max_bitrate, bitrate));
+                LOGI("Adaptive bitrate enabled: %d-%dbps", min_bitrate, MIN(max_bitrate, bitrate));
+            }
+            return true;
+        }
+
+        /**
+         * Multicast settings shared by the RTP/RTCP sinks and the RTCP source
+         */
+        struct MulticastSettings {
+            bool enabled = false;
+            gint ttl = 1;
+            gboolean loop = FALSE;
+            std::string iface;
+        };
+
+        /**
+         * Multicast mode: packets go out once to a group instead of once per
+         * receiver. Replaces the unicast host with the group and fills in the
+         * settings. Leaves everything untouched when no multicast-group
+         * option is given.
+         */
+        bool build_multicast_settings(const GstStructure *options, std::string &destination,
+                                      MulticastSettings &settings) {
+            const gchar *group = options ? gst_structure_get_string(options, "multicast-group") : nullptr;
+            if (!group || !*group) {
+                return true;
+            }
+
+            GInetAddress *address = g_inet_address_new_from_string(group);
+            bool valid = address && g_inet_address_get_is_multicast(address);
+            if (address) {
+                g_object_unref(address);
+            }
+            if (!valid) {
+                set_error(std::string("Not a multicast address: ") + group);
+                return false;
+            }
+
+            gint ttl = 1;
+            gboolean loop = FALSE;
+            gst_structure_get_int(options, "multicast-ttl", &ttl);
+            gst_structure_get_boolean(options, "multicast-loop", &loop);
+            const gchar *iface = gst_structure_get_string(options, "multicast-iface");
+
+            destination = group;
+            multicast_group = group;
+            settings.enabled = true;
+            settings.ttl = CLAMP(ttl, 0, 255);
+            settings.loop = loop;
+            settings.iface = iface ? iface : "";
+
+            LOGI("Multicast to %s (ttl %d, loop %s, iface %s)", group, settings.ttl,
+                 loop ? "on" : "off", iface && *iface ? iface : "default");
+            return true;
+        }
+
+        /**
+         * Apply multicast settings to a multiudpsink, or to the RTCP udpsrc,
+         * which joins the group since receivers send their reports there too
+         */
+        void apply_multicast(GstElement *element, const MulticastSettings &settings, bool source) {
+            if (!settings.enabled) {
+                return;
+            }
+
+            if (source) {
+                g_object_set(G_OBJECT(element),
+                    "address", multicast_group.c_str(),
+                    "auto-multicast", TRUE,
+                    nullptr);
+            } else {
+                g_object_set(G_OBJECT(element),
+                    "auto-multicast", TRUE,
+                    "ttl-mc", settings.ttl,
+                    "loop", settings.loop,
+                    nullptr);
+            }
+
+            if (!settings.iface.empty()) {
+                g_object_set(G_OBJECT(element), "multicast-iface", settings.iface.c_str(), nullptr);
+            }
+        }
+
+        /**
+         * Time-bounded queue that drops its oldest data instead of blocking
+         * upstream
+         */
+        static void configure_leaky_queue(GstElement *queue, guint64 max_time) {
+            g_object_set(G_OBJECT(queue),
+                "max-size-buffers", 0u,
+                "max-size-bytes", 0u,
+                "max-size-time", max_time,
+                nullptr);
+            gst_util_set_object_arg(G_OBJECT(queue), "leaky", "downstream");
+        }
+
+        /**
+         * Retransmission stage, when enabled. rtprtxsend sits right in front
+         * of the session (where rtpbin would put an aux sender), so NACKs the
+         * session receives reach it as upstream retransmission requests.
+         */
+        GstElement *make_rtx_sender(PipelineBuilder &builder, const GstStructure *options) {
+            gboolean rtx = FALSE;
+            gint history_ms = DEFAULT_RTX_HISTORY_MS;
+            if (options) {
+                gst_structure_get_boolean(options, "rtx", &rtx);
+                gst_structure_get_int(options, "rtx-history-ms", &history_ms);
+            }
+            if (!rtx) {
+                return nullptr;
+            }
+
+            GstElement *sender = builder.make("rtprtxsend", "rtxsend");
+            if (!sender) {
+                return nullptr;
+            }
+
+            history_ms = MAX(history_ms, 1);
+            LOGI("Retransmission enabled, %dms history", history_ms);
+
+            GstStructure *payload_types = gst_structure_new("application/x-rtp-pt-map",
+                G_STRINGIFY(OPUS_PAYLOAD_TYPE), G_TYPE_UINT, (guint) OPUS_RTX_PAYLOAD_TYPE,
+                G_STRINGIFY(RED_PAYLOAD_TYPE), G_TYPE_UINT, (guint) RED_RTX_PAYLOAD_TYPE,
+                nullptr);
+            g_object_set(G_OBJECT(sender),
+                "max-size-time", (guint) history_ms,
+                "max-size-packets", 0u,
+                "payload-type-map", payload_types,
+                nullptr);
+            gst_structure_free(payload_types);
+            return sender;
+        }
+
+        /**
+         * RTP sink element: multiudpsink, or with egress=batched our own
+         * batchudpsink, which sends with sendmmsg/GSO instead of one syscall
+         * per packet per destination. Multicast always uses multiudpsink,
+         * which knows how to join groups.
+         */
+        GstElement *make_rtp_sink(PipelineBuilder &builder, const GstStructure *options, bool multicast) {
+            const gchar *egress = options ? gst_structure_get_string(options, "egress") : nullptr;
+            if (!egress || g_strcmp0(egress, "batched") != 0) {
+                return builder.make("multiudpsink", "rtpsink");
+            }
+            if (multicast) {
+                LOGW("Batched egress doesn't support multicast, using multiudpsink");
+                return builder.make("multiudpsink", "rtpsink");
+            }
+            if (!ensure_batched_udp_sink()) {
+                LOGW("batchudpsink unavailable, using multiudpsink");
+                return builder.make("multiudpsink", "rtpsink");
+            }
+
+            gint max_batch = 32;
+            gint max_latency_us = 2000;
+            gst_structure_get_int(options, "egress-max-batch", &max_batch);
+            gst_structure_get_int(options, "egress-max-latency-us", &max_latency_us);
+
+            GstElement *sink = builder.make("batchudpsink", "rtpsink");
+            if (!sink) {
+                return nullptr;
+            }
+
+            g_object_set(G_OBJECT(sink),
+                "max-batch", (guint) CLAMP(max_batch, 1, 1024),
+                "max-latency", (guint64) MAX(max_latency_us, 0) * GST_USECOND,
+                nullptr);
+
+            batched_egress = true;
+            LOGI("Batched egress: up to %d packets or %dus per send", max_batch, max_latency_us);
+            return sink;
+        }
+
+        /**
+         * Local TCP server branch, when tcp-server is "rtp" (RFC 4571 framed
+         * RTP) or "ogg". tcpserversink keeps a separate queue per client and
+         * writes from its own thread; a client whose backlog passes the
+         * soft limit is either resynced to the newest data ("drop") or
+         * disconnected ("disconnect"). Returns the branch's queue, to be
+         * linked to the encoder tee.
+         */
+        GstElement *make_tcp_branch(PipelineBuilder &builder, const GstStructure *options) {
+            const gchar *mode = options ? gst_structure_get_string(options, "tcp-server") : nullptr;
+            if (!mode || g_strcmp0(mode, "none") == 0) {
+                return nullptr;
+            }
+
+            bool rtp = g_strcmp0(mode, "rtp") == 0;
+            if (!rtp && g_strcmp0(mode, "ogg") != 0) {
+                LOGW("Unknown tcp-server mode %s, TCP server disabled", mode);
+                return nullptr;
+            }
+
+            gint port = DEFAULT_TCP_PORT;
+            gint queue_ms = DEFAULT_TCP_CLIENT_QUEUE_MS;
+            gst_structure_get_int(options, "tcp-port", &port);
+            gst_structure_get_int(options, "tcp-client-queue-ms", &queue_ms);
+            const gchar *slow_client = gst_structure_get_string(options, "tcp-slow-client");
+            bool disconnect = g_strcmp0(slow_client, "disconnect") == 0;
+            guint64 soft_limit = (guint64) MAX(queue_ms, 1) * GST_MSECOND;
+
+            GstElement *queue = builder.make("queue");
+            GstElement *payloader = nullptr;
+            GstElement *framer = nullptr;
+            GstElement *muxer = nullptr;
+            if (rtp) {
+                payloader = builder.make("rtpopuspay");
+                framer = builder.make("rtpstreampay");
+            } else {
+                // oggmux's stream headers are replayed to every new client
+                muxer = builder.make("oggmux");
+            }
+            GstElement *server = builder.make("tcpserversink", "tcpserver");
+            if (builder.failed()) {
+                return nullptr;
+            }
+
+            LOGI("TCP server (%s) on port %d, %dms per client, slow clients %s",
+                 mode, port, queue_ms, disconnect ? "disconnected" : "resynced");
+
+            configure_leaky_queue(queue, soft_limit);
+            if (payloader) {
+                g_object_set(G_OBJECT(payloader), "pt", (guint) OPUS_PAYLOAD_TYPE, nullptr);
+            }
+
+            gst_util_set_object_arg(G_OBJECT(server), "sync-method", "latest");
+            gst_util_set_object_arg(G_OBJECT(server), "unit-format", "time");
+            gst_util_set_object_arg(G_OBJECT(server), "recover-policy", disconnect ? "none" : "latest");
+            g_object_set(G_OBJECT(server),
+                "host", "0.0.0.0",
+                "port", port,
+                "sync", FALSE,
+                "async", FALSE,
+                "units-soft-max", (gint64) soft_limit,
+                "units-max", (gint64) (disconnect ? soft_limit : 4 * soft_limit),
+                nullptr);
+
+            builder.link_chain({queue, payloader, framer, muxer, server});
+            return queue;
+        }
+
+        static void on_tcp_client_added(GstElement *sink, GObject *socket, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            std::lock_guard<std::mutex> lock(self->tcp_clients_mutex);
+            self->tcp_clients.push_back(G_SOCKET(g_object_ref(socket)));
+            LOGI("TCP client connected (%zu total)", self->tcp_clients.size());
+        }
+
+        static void on_tcp_client_removed(GstElement *sink, GObject *socket, gint status, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            std::lock_guard<std::mutex> lock(self->tcp_clients_mutex);
+            for (auto it = self->tcp_clients.begin(); it != self->tcp_clients.end(); ++it) {
+                if (G_OBJECT(*it) == socket) {
+                    g_object_unref(*it);
+                    self->tcp_clients.erase(it);
+                    break;
+                }
+            }
+            LOGI("TCP client disconnected (%zu left)", self->tcp_clients.size());
+        }
+
+        static GstPadProbeReturn on_tcp_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+            if (buffer && GST_BUFFER_PTS_IS_VALID(buffer)) {
+                self->tcp_newest_pts.store(GST_BUFFER_PTS(buffer));
+            }
+            return GST_PAD_PROBE_OK;
+        }
+
+        void setup_tcp_server() {
+            tcp_server = gst_bin_get_by_name(GST_BIN(pipeline), "tcpserver");
+            if (!tcp_server) {
+                return;
+            }
+
+            g_signal_connect(tcp_server, "client-added", G_CALLBACK(on_tcp_client_added), this);
+            g_signal_connect(tcp_server, "client-removed", G_CALLBACK(on_tcp_client_removed), this);
+
+            GstPad *pad = gst_element_get_static_pad(tcp_server, "sink");
+            gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, on_tcp_buffer, this, nullptr);
+            gst_object_unref(pad);
+        }
+
+        /**
+         * How far one client is behind the newest data handed to the server
+         */
+        gint64 tcp_client_lag_ms(GstStructure *stats) const {
+            guint64 last_sent = GST_CLOCK_TIME_NONE;
+            guint64 newest = tcp_newest_pts.load();
+            if (!gst_structure_get_uint64(stats, "last-buffer-ts", &last_sent) ||
+                !GST_CLOCK_TIME_IS_VALID(last_sent) || !GST_CLOCK_TIME_IS_VALID(newest) || newest < last_sent) {
+                return 0;
+            }
+            return (gint64) ((newest - last_sent) / GST_MSECOND);
+        }
+
+        /**
+         * UDP socket of the given family with path MTU discovery set to
+         * the dont-fragment policy, for handing over to multiudpsink
+         */
+        static GSocket *make_df_socket(GSocketFamily family, gint df) {
+            bool v6 = family == G_SOCKET_FAMILY_IPV6;
+            GError *error = nullptr;
+            GSocket *socket = g_socket_new(family, G_SOCKET_TYPE_DATAGRAM, G_SOCKET_PROTOCOL_UDP, &error);
+            if (!socket) {
+                LOGW("Could not create %s RTP socket: %s", v6 ? "IPv6" : "IPv4", error->message);
+                g_clear_error(&error);
+                return nullptr;
+            }
+
+            gint mode = df ? IP_PMTUDISC_DO : IP_PMTUDISC_DONT;
+            gint result = v6 ?
+                setsockopt(g_socket_get_fd(socket), IPPROTO_IPV6, IPV6_MTU_DISCOVER, &mode, sizeof(mode)) :
+                setsockopt(g_socket_get_fd(socket), IPPROTO_IP, IP_MTU_DISCOVER, &mode, sizeof(mode));
+            if (result < 0) {
+                LOGW("Could not set don't-fragment policy on the %s socket", v6 ? "IPv6" : "IPv4");
+            }
+            return socket;
+        }
+
+        /**
+         * Socket-level QoS for the RTP sink:
+         * - socket-buffer-size: SO_SNDBUF in bytes
+         * - socket-dscp: DSCP code point, 46 (EF) lands in the WMM voice queue
+         * - dont-fragment: "do" sets DF, "dont" lets the stack fragment,
+         *   anything else keeps the kernel's path MTU discovery default
+         * multiudpsink has no DF property, so for it the IPv4 and IPv6
+         * sockets are created here and handed over.
+         */
+        void apply_socket_qos(const GstStructure *options) {
+            gint buffer_size = -1;
+            gint dscp = -1;
+            const gchar *dont_fragment = nullptr;
+            if (options) {
+                gst_structure_get_int(options, "socket-buffer-size", &buffer_size);
+                gst_structure_get_int(options, "socket-dscp", &dscp);
+                dont_fragment = gst_structure_get_string(options, "dont-fragment");
+            }
+            dscp = CLAMP(dscp, -1, 63);
+            gint df = g_strcmp0(dont_fragment, "do") == 0 ? 1 : g_strcmp0(dont_fragment, "dont") == 0 ? 0 : -1;
+
+            if (batched_egress) {
+                g_object_set(G_OBJECT(rtp_sink),
+                    "buffer-size", buffer_size > 0 ? buffer_size : -1,
+                    "qos-dscp", dscp,
+                    "dont-fragment", df,
+                    nullptr);
+            } else {
+                g_object_set(G_OBJECT(rtp_sink),
+                    "buffer-size", MAX(buffer_size, 0),
+                    "qos-dscp", dscp,
+                    nullptr);
+
+                if (df >= 0) {
+                    // Once it is handed a socket multiudpsink creates none of
+                    // its own, so IPv6 receivers need theirs handed over too
+                    GSocket *socket = make_df_socket(G_SOCKET_FAMILY_IPV4, df);
+                    GSocket *socket_v6 = make_df_socket(G_SOCKET_FAMILY_IPV6, df);
+                    if (socket) {
+                        g_object_set(G_OBJECT(rtp_sink), "socket", socket, nullptr);
+                        g_object_unref(socket);
+                    }
+                    if (socket_v6) {
+                        g_object_set(G_OBJECT(rtp_sink), "socket-v6", socket_v6, nullptr);
+                        g_object_unref(socket_v6);
+                    }
+                    if (socket || socket_v6) {
+                        g_object_set(G_OBJECT(rtp_sink), "close-socket", TRUE, nullptr);
+                    }
+                }
+            }
+
+            LOGI("RTP socket: sndbuf %s, DSCP %s, DF %s",
+                 buffer_size > 0 ? std::to_string(buffer_size).c_str() : "default",
+                 dscp >= 0 ? std::to_string(dscp).c_str() : "unmarked",
+                 df < 0 ? "default" : df ? "set" : "cleared");
+        }
+
+        /**
+         * Frame aggregation in front of the payloader: rtp-ptime-ms of audio
+         * per packet (0 keeps one frame per packet), never more than
+         * rtp-max-ptime-ms or what fits in mtu. Returns nullptr when frames
+         * go to the payloader as they are.
+         */
+        GstElement *make_packetizer(PipelineBuilder &builder, const GstStructure *options) {
+            gint ptime_ms = 0;
+            gint max_ptime_ms = 120;
+            gint mtu = DEFAULT_RTP_MTU;
+            if (options) {
+                gst_structure_get_int(options, "rtp-ptime-ms", &ptime_ms);
+                gst_structure_get_int(options, "rtp-max-ptime-ms", &max_ptime_ms);
+                gst_structure_get_int(options, "mtu", &mtu);
+            }
+            _mtu = CLAMP(mtu, 576, 65535);
+
+            if (!ensure_opus_aggregator()) {
+                LOGW("opusaggregate unavailable, one frame per packet");
+                return nullptr;
+            }
+
+            GstElement *element = builder.make("opusaggregate", "aggregator");
+            if (!element) {
+                return nullptr;
+            }
+
+            ptime_ms = CLAMP(ptime_ms, 0, 120);
+            max_ptime_ms = CLAMP(max_ptime_ms, MAX(ptime_ms, 1), 120);
+            LOGI("Packetization: ptime %dms, max-ptime %dms, mtu %d", ptime_ms, max_ptime_ms, _mtu);
+
+            g_object_set(G_OBJECT(element),
+                "ptime", (guint64) ptime_ms * GST_MSECOND,
+                "max-ptime", (guint64) max_ptime_ms * GST_MSECOND,
+                "mtu", (guint) _mtu,
+                nullptr);
+            return element;
+        }
+
+        static GstPadProbeReturn on_rtp_packet(GstPad *pad, GstPadProbeInfo *info, gpointer data) {
+            AudioPipeline *self = static_cast<AudioPipeline*>(data);
+            if (self->first_packet_pending.exchange(false)) {
+                gint64 elapsed = g_get_monotonic_time() - self->first_packet_requested_us.load();
+                self->time_to_first_packet_us.store(elapsed);
+                LOGI("First packet after %.2fms", elapsed / 1000.0);
+
+                gint64 unset = -1;
+                gint64 cold_start = g_get_monotonic_time() - self->init_started_us;
+                if (self->cold_start_us.compare_exchange_strong(unset, cold_start)) {
+                    LOGI("Cold start to first packet %.2fms", cold_start / 1000.0);
+                }
+            }
+            return GST_PAD_PROBE_OK;
+        }
+
+        /**
+         * Start timing until the next RTP packet reaches the sink
+         */
+        void arm_first_packet_timer() {
+            first_packet_requested_us.store(g_get_monotonic_time());
+            first_packet_pending.store(true);
+        }
+
+    public:
+        /**
+         * Initialize the GStreamer pipeline
+         *
+         * Creates pipeline: appsrc ! [audioconvert] ! [audioresample] ! opusenc ! rtpopuspay ! rtpbin ! udpsink
+         * With an output path the encoder output is tee'd to: queue ! oggmux ! filesink
+         * Elements come from ElementFactoryCache through a PipelineBuilder,
+         * so init does no parsing, registry lookups or property string
+         * conversion. Time spent creating, linking and configuring is kept
+         * for the stats.
+         */
+        bool init(
+                JNIEnv *env,
+                const std::string &host,
+                gint sample_rate,
+                gint channels,
+                const std::string &format,
+                const std::string &output_path,
+                gint bitrate,
+                gsize period_size,
+                const GstStructure *options,
+                jobject listener
+                ) {
+            if (is_initialized) {
+                LOGW("Pipeline already initialized");
+                cleanup();
+            }
+            init_started_us = g_get_monotonic_time();
+            cold_start_us.store(-1);
+
+            // Interleaved little-endian PCM, as AudioRecord writes it into a
+            // direct buffer for ENCODING_PCM_16BIT and ENCODING_PCM_FLOAT
+            if (format == "S16LE") {
+                this->_bytes_per_sample = 2;
+            } else if (format == "F32LE") {
+                this->_bytes_per_sample = 4;
+            } else {
+                set_error("Unsupported sample format: " + format);
+                return false;
+            }
+
+            this->_sample_rate = sample_rate;
+            this->_channels = channels;
+            this->_format = format;
+            this->_period_size = period_size;
+
+            ts_anchor = GST_CLOCK_TIME_NONE;
+            ts_samples = 0;
+            ts_discont = true;
+
+            LOGI("Initializing pipeline: %s %dHz, %dch, %dbps, %zu byte periods -> %s",
+                 format.c_str(), sample_rate, channels, bitrate, period_size, output_path.c_str());
+
+            // Input caps as AudioRecord delivers them
+            GstCaps *caps = gst_caps_new_simple("audio/x-raw",
+                "format", G_TYPE_STRING, _format.c_str(),
+                "rate", G_TYPE_INT, sample_rate,
+                "channels", G_TYPE_INT, channels,
+                "layout", G_TYPE_STRING, "interleaved",
+                nullptr);
+
+            // Build the graph from cached factories, with conversion only
+            // where the encoder can't take the input as is. RTP goes out
+            // through an rtpbin session so receiver reports arriving on
+            // RTCP_PORT can drive the bitrate; both sinks hold a client list
+            // that can change live.
+            _port = RTP_PORT;
+            local_ports = bound_ports(options);
+            MulticastSettings multicast;
+            std::string destination = host;
+            if (!build_multicast_settings(options, destination, multicast)) {
+                gst_caps_unref(caps);
+                return false;
+            }
+
+            std::string clients, rtcp_clients;
+            if (!destination.empty()) {
+                destinations.push_back(destination);
+                clients = destination + ":" + std::to_string(_port);
+                rtcp_clients = destination + ":" + std::to_string(_port + 1);
+            }
+
+            pipeline = gst_pipeline_new("pipeline");
+            PipelineBuilder builder(GST_BIN(pipeline));
+
+            GstElement *session = builder.make("rtpbin", "rtpbin");
+            GstElement *rtp_out = make_rtp_sink(builder, options, multicast.enabled);
+            GstElement *rtcp_out = builder.make("multiudpsink", "rtcpsink");
+            GstElement *rtcp_in = builder.make("udpsrc", "rtcpsrc");
+            GstElement *source = builder.make("appsrc", "audiosrc");
+
+            std::vector<GstElement*> encode_chain;
+            for (const char *converter : plan_conversion(caps, "opusenc")) {
+                encode_chain.push_back(builder.make(converter));
+            }
+            GstElement *opus = builder.make("opusenc", "encoder");
+            encode_chain.push_back(opus);
+
+            // Frames are aggregated before the payloader. FEC stage between
+            // payloader and session: ULPFEC repair packets first, then RED so
+            // redundancy also covers them
+            GstElement *packetizer = make_packetizer(builder, options);
+            GstElement *payloader = builder.make("rtpopuspay", "payloader");
+            GstElement *ulpfec = builder.make("rtpulpfecenc", "fecenc");
+            GstElement *red = builder.make("rtpredenc", "redenc");
+            GstElement *rtx = make_rtx_sender(builder, options);
+
+            // One encode feeds every consumer. The network branch runs in the
+            // encoder's streaming thread with no queue, while the file and
+            // TCP branches sit behind leaky queues in their own threads, so
+            // slow flash or slow clients can only ever drop their own audio
+            // and never back-pressure the live stream.
+            std::vector<GstElement*> branches = { packetizer ? packetizer : payloader };
+
+            if (!output_path.empty()) {
+                GstElement *file_queue = builder.make("queue");
+                GstElement *muxer = builder.make("oggmux");
+                GstElement *file_sink = builder.make("filesink");
+                if (!builder.failed()) {
+                    configure_leaky_queue(file_queue, (guint64) FILE_QUEUE_MAX_MS * GST_MSECOND);
+                    g_object_set(G_OBJECT(file_sink),
+                        "location", output_path.c_str(),
+                        "sync", FALSE,
+                        "async", FALSE,
+                        nullptr);
+                }
+                builder.link_chain({file_queue, muxer, file_sink});
+                branches.push_back(file_queue);
+            }
+
+            GstElement *tcp_branch = make_tcp_branch(builder, options);
+            if (tcp_branch) {
+                branches.push_back(tcp_branch);
+            }
+
+            GstElement *tee = branches.size() > 1 ? builder.make("tee", "encoded") : nullptr;
+
+            if (builder.failed()) {
+                set_error(builder.get_error());
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+
+            // Typed properties, set directly instead of parsed from strings
+            gst_util_set_object_arg(G_OBJECT(session), "rtp-profile", "avpf");
+
+            g_object_set(G_OBJECT(rtp_out), "sync", FALSE, nullptr);
+            g_object_set(G_OBJECT(rtcp_out), "sync", FALSE, "async", FALSE, nullptr);
+            if (!clients.empty()) {
+                g_object_set(G_OBJECT(rtp_out), "clients", clients.c_str(), nullptr);
+                g_object_set(G_OBJECT(rtcp_out), "clients", rtcp_clients.c_str(), nullptr);
+            }
+            apply_multicast(rtp_out, multicast, false);
+            apply_multicast(rtcp_out, multicast, false);
+
+            gint rtcp_port = RTCP_PORT;
+            if (options) {
+                gst_structure_get_int(options, "rtcp-port", &rtcp_port);
+            }
+            g_object_set(G_OBJECT(rtcp_in), "port", rtcp_port, nullptr);
+            _rtcp_port = rtcp_port;
+            apply_multicast(rtcp_in, multicast, true);
+
+            g_object_set(G_OBJECT(source), "is-live", TRUE, "format", GST_FORMAT_TIME, nullptr);
+            g_object_set(G_OBJECT(opus), "bitrate", bitrate, nullptr);
+            g_object_set(G_OBJECT(payloader), "pt", (guint) OPUS_PAYLOAD_TYPE, "mtu", (guint) _mtu, nullptr);
+            g_object_set(G_OBJECT(ulpfec), "pt", (guint) ULPFEC_PAYLOAD_TYPE, "percentage", 0u, nullptr);
+            g_object_set(G_OBJECT(red),
+                "pt", RED_PAYLOAD_TYPE,
+                "distance", 0u,
+                "allow-no-red-blocks", FALSE,
+                nullptr);
+
+            // Explicit caps where the media type changes: raw input, encoded
+            // Opus, Opus RTP
+            builder.link(source, encode_chain.front(), gst_caps_ref(caps));
+            for (size_t i = 1; i < encode_chain.size(); i++) {
+                builder.link(encode_chain[i - 1], encode_chain[i]);
+            }
+
+            GstCaps *opus_caps = gst_caps_new_empty_simple("audio/x-opus");
+            if (tee) {
+                builder.link(opus, tee, opus_caps);
+                for (GstElement *branch : branches) {
+                    builder.link(tee, branch);
+                }
+            } else {
+                builder.link(opus, branches.front(), opus_caps);
+            }
+
+            builder.link_chain({packetizer, payloader});
+            builder.link(payloader, ulpfec, gst_caps_new_simple("application/x-rtp",
+                "media", G_TYPE_STRING, "audio",
+                "payload", G_TYPE_INT, OPUS_PAYLOAD_TYPE,
+                nullptr));
+            builder.link_chain({ulpfec, red, rtx});
+
+            // Session pads: the send sink is requested first, which creates
+            // the session and its send source
+            builder.link_pads(rtx ? rtx : red, "src", session, "send_rtp_sink_0");
+            builder.link_pads(session, "send_rtp_src_0", rtp_out, "sink");
+            builder.link_pads(session, "send_rtcp_src_0", rtcp_out, "sink");
+            builder.link_pads(rtcp_in, "src", session, "recv_rtcp_sink_0");
+
+            if (builder.failed()) {
+                set_error(builder.get_error());
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+
+            init_create_us = builder.get_create_us();
+            init_link_us = builder.get_link_us();
+
+            // Get appsrc element
+            appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "audiosrc");
+            if (!appsrc) {
+                set_error("Failed to get appsrc element");
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+
+            // Configure the encoder from its profile
+            encoder = gst_bin_get_by_name(GST_BIN(pipeline), "encoder");
+            if (!encoder) {
+                set_error("Failed to get encoder element");
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+
+            const gchar *profile = options ? gst_structure_get_string(options, "encoder-profile") : nullptr;
+            if (!encoder_config.load_preset(profile ? profile : "default")) {
+                set_error(std::string("Unknown encoder profile: ") + profile);
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+            if (options) {
+                encoder_options = gst_structure_copy(options);
+                encoder_config.apply_overrides(StructureOptions(encoder_options));
+            }
+            apply_encoder_config(encoder_config, encoder);
+
+            red_encoder = gst_bin_get_by_name(GST_BIN(pipeline), "redenc");
+            fec_encoder = gst_bin_get_by_name(GST_BIN(pipeline), "fecenc");
+            apply_fec_config(encoder_config, red_encoder, fec_encoder);
+            LOGI("Encoder profile %s: %s", profile ? profile : "default", encoder_config.describe().c_str());
+
+            rtx_sender = gst_bin_get_by_name(GST_BIN(pipeline), "rtxsend");
+            aggregator = gst_bin_get_by_name(GST_BIN(pipeline), "aggregator");
+            setup_tcp_server();
+
+            rtp_sink = gst_bin_get_by_name(GST_BIN(pipeline), "rtpsink");
+            rtcp_sink = gst_bin_get_by_name(GST_BIN(pipeline), "rtcpsink");
+            if (!rtp_sink || !rtcp_sink) {
+                set_error("Failed to get network sinks");
+                gst_caps_unref(caps);
+                cleanup();
+                return false;
+            }
+            apply_socket_qos(options);
+
+            GstPad *rtp_pad = gst_element_get_static_pad(rtp_sink, "sink");
+            gst_pad_add_probe(rtp_pad,
+                static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                on_rtp_packet, this, nullptr);
+            gst_object_unref(rtp_pad);
+
+            // RTCP receiver reports -> encoder
+            rtpbin = gst_bin_get_by_name(GST_BIN(pipeline), "rtpbin");
+            if (!rtpbin || !setup_rtcp_feedback(bitrate, options)) {
+                LOGW("RTCP feedback unavailable, bitrate stays at %dbps", bitrate);
+            }
+
+            // Configure appsrc caps
+            guint64 max_queue_bytes = (guint64)(sample_rate * frame_size() * 2); // 2 seconds buffer
+            _max_queue_bytes = max_queue_bytes;
+
+            backpressure = parse_backpressure(options ?
+                gst_structure_get_string(options, "backpressure") : nullptr);
+
+            // Only the block policy lets appsrc block; the others keep the
+            // queue bounded themselves from the enough-data/need-data callbacks
+            g_object_set(G_OBJECT(appsrc),
+                "caps", caps,
+                "stream-type", GST_APP_STREAM_TYPE_STREAM,
+                "format", GST_FORMAT_TIME,
+                "max-bytes", max_queue_bytes,
+                "block", backpressure == BACKPRESSURE_BLOCK,
+                nullptr);
+
+            GstAppSrcCallbacks callbacks = {};
+            callbacks.need_data = on_need_data;
+            callbacks.enough_data = on_enough_data;
+            gst_app_src_set_callbacks(GST_APP_SRC(appsrc), &callbacks, this, nullptr);
+            appsrc_full.store(false);
+
+            if (!setup_buffer_pool(caps, max_queue_bytes)) {
+                LOGW("Buffer pool unavailable, push_data will allocate per period");
+            }
+
+            gst_caps_unref(caps);
+
+            // Setup the capture -> pusher ring
+            gint ring_capacity_ms = DEFAULT_RING_CAPACITY_MS;
+            gint max_batch_periods = 1;
+            if (options) {
+                gst_structure_get_int(options, "ring-capacity-ms", &ring_capacity_ms);
+                gst_structure_get_int(options, "max-batch-periods", &max_batch_periods);
+            }
+            _max_batch_periods = (guint) CLAMP(max_batch_periods, 1, 64);
+            setup_ring(MAX(ring_capacity_ms, 1));
+
+            // Setup slabs for the zero-copy direct buffer path, large enough
+            // for a whole batch
+            if (period_size > 0 && env) {
+                direct_pool = std::make_unique<DirectBufferPool>();
+                if (!direct_pool->init(env, period_size * _max_batch_periods, DIRECT_SLAB_COUNT)) {
+                    LOGW("Direct buffer pool unavailable, using copying feed path");
+                    direct_pool.reset();
+                }
+            }
+
+            // Bus messages are handled on a thread of our own
+            start_bus_thread(env, listener);
+
+            is_initialized = true;
+            init_configure_us = g_get_monotonic_time() - init_started_us - init_create_us - init_link_us;
+            LOGI("Pipeline initialized successfully (create %.2fms, link %.2fms, configure %.2fms)",
+                 init_create_us / 1000.0, init_link_us / 1000.0, init_configure_us / 1000.0);
+            record_first_pipeline_time(g_get_monotonic_time() - init_started_us);
+            return true;
+        }
+
+        /**
+         * Start the pipeline
+         */
+        bool start() {
+            if (!is_initialized) {
+                set_error("Pipeline not initialized");
+                return false;
+            }
+
+            LOGI("Starting pipeline");
+
+            arm_first_packet_timer();
+            gint64 begin = g_get_monotonic_time();
+            GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            start_us = g_get_monotonic_time() - begin;
+            if (ret == GST_STATE_CHANGE_FAILURE) {
+                set_error("Failed to start pipeline");
+                return false;
+            }
+
+            start_pusher();
+
+            LOGI("Pipeline started successfully");
+            return true;
+        }
+
+        /**
+         * Feed audio data to the pipeline
+         * Copies the data into a pooled GstBuffer, used for the byte[] path
+         */
+        bool push_data(const guint8 *data, gsize size) {
+            if (!is_initialized || !appsrc) {
+                return false;
+            }
+            if (is_mirror.load()) {
+                set_error("Mirror sessions are fed by the session they mirror");
+                return false;
+            }
+
+            // Get buffer and copy data
+            GstBuffer *buffer = copy_to_buffer(data, size);
+            if (!buffer) {
+                return false;
+            }
+
+            return queue_buffer(buffer);
+        }
+
+        /**
+         * Feed audio data from a direct ByteBuffer
+         *
+         * When the address belongs to a slab lent out by acquire_direct_buffer
+         * the slab itself is wrapped and pushed (zero copy). Any other direct
+         * buffer falls back to the copying path.
+         */
+        bool push_direct(guint8 *data, gsize size) {
+            DirectBufferPool::Slab *slab = direct_pool ? direct_pool->find_lent(data) : nullptr;
+
+            // Only the capture thread of the session feeding a mirror may
+            // produce into its ring
+            if (is_mirror.load()) {
+                if (slab) {
+                    DirectBufferPool::give_back(slab);
+                }
+                set_error("Mirror sessions are fed by the session they mirror");
+                return false;
+            }
+
+            if (!slab) {
+                return size > 0 ? push_data(data, size) : true;
+            }
+
+            if (!is_initialized || !appsrc || size == 0 || size > direct_pool->get_slab_size()) {
+                DirectBufferPool::give_back(slab);
+                return size == 0;
+            }
+
+            return queue_buffer(direct_pool->wrap(slab, size));
+        }
+
+        /**
+         * Feed several consecutive periods from one direct ByteBuffer region
+         *
+         * The region is split at period_size boundaries (the last period may
+         * be shorter) and pushed as a single GstBufferList, so one JNI call,
+         * one ring slot and one appsrc push cover the whole batch. Periods of
+         * a lent slab share the slab memory; anything else is copied.
+         */
+        bool push_direct_batch(guint8 *data, gsize size, gsize period_size) {
+            DirectBufferPool::Slab *slab = direct_pool ? direct_pool->find_lent(data) : nullptr;
+
+            if (is_mirror.load()) {
+                if (slab) {
+                    DirectBufferPool::give_back(slab);
+                }
+                set_error("Mirror sessions are fed by the session they mirror");
+                return false;
+            }
+
+            if (!is_initialized || !appsrc || size == 0 || period_size == 0 ||
+                (slab && size > direct_pool->get_slab_size())) {
+                if (slab) {
+                    DirectBufferPool::give_back(slab);
+                }
+                return size == 0;
+            }
+
+            guint periods = (guint) ((size + period_size - 1) / period_size);
+            GstBufferList *list = gst_buffer_list_new_sized(periods);
+            GstBuffer *region = slab ? direct_pool->wrap(slab, size) : nullptr;
+
+            for (gsize offset = 0; offset < size; offset += period_size) {
+                gsize length = MIN(period_size, size - offset);
+                GstBuffer *buffer = region ?
+                    gst_buffer_copy_region(region, GST_BUFFER_COPY_MEMORY, offset, length) :
+                    copy_to_buffer(data + offset, length);
+
+                if (!buffer) {
+                    if (region) {
+                        gst_buffer_unref(region);
+                    }
+                    gst_buffer_list_unref(list);
+                    return false;
+                }
+
+                gst_buffer_list_add(list, buffer);
+            }
+
+            // The slab returns to the pool once the last period is released
+            if (region) {
+                gst_buffer_unref(region);
+            }
+
+            return queue_buffer_list(list);
+        }
+
+        /**
+         * Lend a native slab to Java as a direct ByteBuffer
+         * Ownership returns to native with the next push_direct of that buffer
+         */
+        jobject acquire_direct_buffer() {
+            if (!is_initialized || !direct_pool || is_mirror.load()) {
+                return nullptr;
+            }
+
+            DirectBufferPool::Slab *slab = direct_pool->lend();
+            return slab ? slab->byte_buffer : nullptr;
+        }
+
+        /**
+         * Push a filled buffer or buffer list to appsrc
+         * Following GStreamer best practice: use gst_app_src_push_buffer
+         */
+        bool push_item(GstMiniObject *item) {
+            GstFlowReturn ret;
+
+            // Push to appsrc (takes ownership of the item)
+            if (GST_IS_BUFFER_LIST(item)) {
+                ret = gst_app_src_push_buffer_list(GST_APP_SRC(appsrc), GST_BUFFER_LIST_CAST(item));
+            } else {
+                ret = gst_app_src_push_buffer(GST_APP_SRC(appsrc), GST_BUFFER_CAST(item));
+            }
+
+            if (ret != GST_FLOW_OK) {
+                set_error(std::string("Push buffer failed: ") + gst_flow_get_name(ret));
+                return false;
+            }
+
+            return true;
+        }
+
+        /**
+         * Run on a clock and base time shared with the other sessions, so
+         * their running times line up and a mirror can take our timestamps.
+         * Must be called before start(). With no start time the base time
+         * also stays put across pause() and resume().
+         */
+        void use_clock(GstClock *clock, GstClockTime base_time) {
+            if (!pipeline) {
+                return;
+            }
+
+            gst_pipeline_use_clock(GST_PIPELINE(pipeline), clock);
+            gst_element_set_start_time(pipeline, GST_CLOCK_TIME_NONE);
+            gst_element_set_base_time(pipeline, base_time);
+        }
+
+        /**
+         * Local ports a session built from these options listens on: its
+         * RTCP receive port, and the TCP server port when it runs one.
+         * The RTP and RTCP senders use ephemeral ports.
+         */
+        static std::vector<gint> bound_ports(const GstStructure *options) {
+            gint rtcp_port = RTCP_PORT;
+            const gchar *tcp_mode = nullptr;
+            if (options) {
+                gst_structure_get_int(options, "rtcp-port", &rtcp_port);
+                tcp_mode = gst_structure_get_string(options, "tcp-server");
+            }
+
+            std::vector<gint> ports = { rtcp_port };
+            if (tcp_mode && g_strcmp0(tcp_mode, "none") != 0) {
+                gint tcp_port = DEFAULT_TCP_PORT;
+                gst_structure_get_int(options, "tcp-port", &tcp_port);
+                ports.push_back(tcp_port);
+            }
+            return ports;
+        }
+
+        const std::vector<gint> &get_local_ports() const {
+            return local_ports;
+        }
+
+        void set_session_handle(jlong handle) {
+            session_handle.store(handle);
+        }
+
+        /**
+         * Encode this pipeline's capture in another session too
+         * The mirror must take the same raw format, and can't be fed on its
+         * own or mirror anything itself.
+         */
+        bool add_mirror(const std::shared_ptr<AudioPipeline> &mirror) {
+            if (!is_initialized || !mirror || !mirror->is_initialized || mirror.get() == this) {
+                set_error("Invalid mirror session");
+                return false;
+            }
+            if (is_mirror.load() || mirror->has_mirrors.load()) {
+                set_error("Mirror sessions can't be chained");
+                return false;
+            }
+            if (mirror->_format != _format || mirror->_sample_rate != _sample_rate ||
+                mirror->_channels != _channels) {
+                set_error("Mirror session takes a different input format");
+                return false;
+            }
+
+            std::lock_guard<std::mutex> lock(mirrors_mutex);
+            if (std::find(mirrors.begin(), mirrors.end(), mirror) != mirrors.end()) {
+                return true;
+            }
+            if (mirror->is_mirror.exchange(true)) {
+                set_error("Session already mirrors another one");
+                return false;
+            }
+            mirrors.push_back(mirror);
+            has_mirrors.store(true);
+
+            LOGI("Session %lld mirrors session %lld",
+                 (long long) mirror->session_handle.load(), (long long) session_handle.load());
+            return true;
+        }
+
+        /**
+         * Stop feeding a mirror; once this returns it gets no more buffers
+         */
+        void remove_mirror(const AudioPipeline *mirror) {
+            std::lock_guard<std::mutex> lock(mirrors_mutex);
+            for (auto it = mirrors.begin(); it != mirrors.end(); ++it) {
+                if (it->get() == mirror) {
+                    (*it)->is_mirror.store(false);
+                    mirrors.erase(it);
+                    break;
+                }
+            }
+            has_mirrors.store(!mirrors.empty());
+        }
+
+        /**
+         * Stop feeding all mirrors; they can be fed directly again once this
+         * returns
+         */
+        void clear_mirrors() {
+            std::lock_guard<std::mutex> lock(mirrors_mutex);
+            for (const std::shared_ptr<AudioPipeline> &mirror : mirrors) {
+                mirror->is_mirror.store(false);
+            }
+            mirrors.clear();
+            has_mirrors.store(false);
+        }
+
+        /**
+         * Go to warm standby: PAUSED keeps sockets, negotiated caps and the
+         * encoder state, so resume() only has to restart the clock
+         */
+        bool pause() {
+            if (!is_initialized || paused.load()) {
+                return is_initialized;
+            }
+
+            // Let the pusher hand over what was already captured so the
+            // tail still goes out before the stream stops
+            for (gint i = 0; i < 20 && ring && !ring->empty(); i++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
 
-        std::string last_error;
-        bool is_initialized = false;
+            GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+            if (ret == GST_STATE_CHANGE_FAILURE) {
+                set_error("Failed to pause pipeline");
+                return false;
+            }
 
-        // Audio parameters
-        gint _sample_rate = 0;
-        gint _channels = 0;
+            paused.store(true);
+            LOGI("Pipeline in standby");
+            return true;
+        }
 
         /**
-         * Bus message callback - handles pipeline messages
+         * Leave standby; the first packet time is measured from here
          */
-        static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data) {
-            AudioPipeline *pipeline = static_cast<AudioPipeline*>(data);
+        bool resume() {
+            if (!is_initialized) {
+                set_error("Pipeline not initialized");
+                return false;
+            }
+            if (!paused.load()) {
+                return true;
+            }
 
-            switch (GST_MESSAGE_TYPE(msg)) {
-                case GST_MESSAGE_ERROR: {
-                    GError *err = nullptr;
-                    gchar *debug_info = nullptr;
-                    gst_message_parse_error(msg, &err, &debug_info);
+            // Audio after the pause doesn't follow on from what came before
+            ts_discont = true;
 
-                    pipeline->last_error = std::string("GStreamer error: ") + err->message;
-                    LOGE("Pipeline error from %s: %s", GST_OBJECT_NAME(msg->src), err->message);
-                    LOGE("Debug info: %s", debug_info ? debug_info : "none");
+            arm_first_packet_timer();
+            GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            if (ret == GST_STATE_CHANGE_FAILURE) {
+                set_error("Failed to resume pipeline");
+                first_packet_pending.store(false);
+                return false;
+            }
 
-                    g_clear_error(&err);
-                    g_free(debug_info);
-                    break;
-                }
+            paused.store(false);
+            LOGI("Pipeline resumed");
+            return true;
+        }
 
-                case GST_MESSAGE_WARNING: {
-                    GError *err = nullptr;
-                    gchar *debug_info = nullptr;
-                    gst_message_parse_warning(msg, &err, &debug_info);
+        /**
+         * Stop the pipeline gracefully
+         * Following GStreamer best practice: send EOS and wait for completion
+         *
+         * Drains the ring, sends EOS and waits up to timeout for it to reach
+         * the sinks, then sets NULL. Returns whether EOS made it through.
+         * Only the first call does anything, later ones return true.
+         */
+        bool stop(GstClockTime timeout = DEFAULT_STOP_DEADLINE_MS * GST_MSECOND) {
+            if (!is_initialized || stopped) {
+                return true;
+            }
+            stopped = true;
 
-                    LOGW("Pipeline warning from %s: %s", GST_OBJECT_NAME(msg->src), err->message);
+            LOGI("Stopping pipeline");
+            gint64 begin = g_get_monotonic_time();
 
-                    g_clear_error(&err);
-                    g_free(debug_info);
-                    break;
-                }
+            // EOS only flows while playing
+            if (paused.exchange(false)) {
+                gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            }
 
-                case GST_MESSAGE_EOS:
-                    LOGI("End-of-stream reached");
-                    break;
+            // Drain whatever the capture thread queued
+            stop_pusher();
 
-                case GST_MESSAGE_STATE_CHANGED:
-                    if (GST_MESSAGE_SRC(msg) == GST_OBJECT(pipeline->pipeline)) {
-                        GstState old_state, new_state, pending_state;
-                        gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
-                        LOGD("Pipeline state: %s -> %s",
-                             gst_element_state_get_name(old_state),
-                             gst_element_state_get_name(new_state));
-                    }
-                    break;
+            // Send EOS to appsrc for graceful shutdown
+            if (appsrc) {
+                gst_app_src_end_of_stream(GST_APP_SRC(appsrc));
+            }
 
-                default:
-                    break;
+            // Wait for the bus thread to see EOS, in whatever time is left
+            bool drained = false;
+            {
+                gint64 elapsed_us = g_get_monotonic_time() - begin;
+                gint64 timeout_us = (gint64) (timeout / GST_USECOND);
+                std::unique_lock<std::mutex> lock(bus_mutex);
+                bus_cv.wait_for(lock, std::chrono::microseconds(MAX(timeout_us - elapsed_us, 0)),
+                                [this] { return eos_seen || error_seen; });
+
+                drained = eos_seen;
+                if (error_seen) {
+                    LOGW("Error during shutdown");
+                } else if (!eos_seen) {
+                    LOGW("Timeout waiting for EOS");
+                }
             }
 
-            return TRUE;
+            // Set to NULL state
+            if (pipeline) {
+                gst_element_set_state(pipeline, GST_STATE_NULL);
+            }
+
+            LOGI("Pipeline stopped");
+            return drained;
         }
 
-    public:
         /**
-         * Initialize the GStreamer pipeline
-         *
-         * Creates pipeline: appsrc ! audioconvert ! audioresample ! opusenc ! oggmux ! filesink
-         * Following GStreamer best practice: use gst_parse_launch for simple pipelines
+         * Hard stop for a graceful stop that is stuck: NULL unblocks the
+         * sinks and a blocked appsrc, so the draining thread can finish.
+         * Safe to call while stop() runs on another thread.
          */
-        bool init(
-                const std::string &host,
-                gint sample_rate,
-                gint channels,
-                const std::string &output_path,
-                gint bitrate
-                ) {
-            if (is_initialized) {
-                LOGW("Pipeline already initialized");
-                cleanup();
+        void force_stop() {
+            if (pipeline) {
+                LOGW("Forcing pipeline to NULL");
+                gst_element_set_state(pipeline, GST_STATE_NULL);
             }
+        }
 
-            this->_sample_rate = sample_rate;
-            this->_channels = channels;
+        /**
+         * Cleanup all resources
+         * Following RAII principles for resource management
+         */
+        void cleanup() {
+            LOGD("Cleaning up pipeline");
 
-            LOGI("Initializing pipeline: %dHz, %dch, %dbps -> %s",
-                 sample_rate, channels, bitrate, output_path.c_str());
+            clear_mirrors();
+            stop_pusher();
 
-            // Build pipeline string
-            std::string pipeline_desc =
-                "appsrc name=audiosrc is-live=true format=time "
-                "! audioconvert "
-                "! audioresample "
-                "! opusenc bitrate=" + std::to_string(bitrate) + " "
-                "! rtpopuspay "
-                "! udpsink host=" + host + " port=5004 sync=false";
+            // Stop streaming threads first; the RTCP thread touches the encoder
+            if (pipeline) {
+                gst_element_set_state(pipeline, GST_STATE_NULL);
+            }
 
-            // Parse and create pipeline
-            GError *error = nullptr;
-            pipeline = gst_parse_launch(pipeline_desc.c_str(), &error);
+            if (ring) {
+                GstMiniObject *item = nullptr;
+                while (ring->pop(item)) {
+                    gst_mini_object_unref(item);
+                }
 
-            if (!pipeline || error) {
-                last_error = error ? error->message : "Failed to create pipeline";
-                LOGE("%s", last_error.c_str());
-                g_clear_error(&error);
-                return false;
+                LOGI("Ring: %llu overruns, %llu underruns, %llu discontinuities",
+                     (unsigned long long) ring_overruns.load(),
+                     (unsigned long long) ring_underruns.load(),
+                     (unsigned long long) discont_count.load());
+                LOGI("Dropped: %llu buffers, %llu samples, %llu ms",
+                     (unsigned long long) dropped_buffers.load(),
+                     (unsigned long long) dropped_samples.load(),
+                     (unsigned long long) (dropped_duration.load() / GST_MSECOND));
+                ring.reset();
             }
 
-            // Get appsrc element
-            appsrc = gst_bin_get_by_name(GST_BIN(pipeline), "audiosrc");
-            if (!appsrc) {
-                last_error = "Failed to get appsrc element";
-                LOGE("%s", last_error.c_str());
-                cleanup();
-                return false;
+            stop_bus_thread();
+
+            if (appsrc) {
+                gst_object_unref(appsrc);
+                appsrc = nullptr;
             }
 
-            // Configure appsrc caps
-            GstCaps *caps = gst_caps_new_simple("audio/x-raw",
-                "format", G_TYPE_STRING, "S16LE",
-                "rate", G_TYPE_INT, sample_rate,
-                "channels", G_TYPE_INT, channels,
-                "layout", G_TYPE_STRING, "interleaved",
-                nullptr);
+            if (encoder) {
+                gst_object_unref(encoder);
+                encoder = nullptr;
+            }
 
-            g_object_set(G_OBJECT(appsrc),
-                "caps", caps,
-                "stream-type", GST_APP_STREAM_TYPE_STREAM,
-                "format", GST_FORMAT_TIME,
-                "max-bytes", (guint64)(sample_rate * channels * 2 * 2), // 2 seconds buffer
-                nullptr);
+            if (rtpbin) {
+                gst_object_unref(rtpbin);
+                rtpbin = nullptr;
+            }
 
-            gst_caps_unref(caps);
+            if (red_encoder) {
+                gst_object_unref(red_encoder);
+                red_encoder = nullptr;
+            }
 
-            // Setup bus watch for messages
-            bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
-            bus_watch_id = gst_bus_add_watch(bus, bus_callback, this);
-            gst_object_unref(bus);
+            if (fec_encoder) {
+                gst_object_unref(fec_encoder);
+                fec_encoder = nullptr;
+            }
 
-            is_initialized = true;
-            LOGI("Pipeline initialized successfully");
-            return true;
+            if (rtx_sender) {
+                gst_object_unref(rtx_sender);
+                rtx_sender = nullptr;
+            }
+
+            if (aggregator) {
+                gst_object_unref(aggregator);
+                aggregator = nullptr;
+            }
+
+            if (rtp_sink) {
+                gst_object_unref(rtp_sink);
+                rtp_sink = nullptr;
+            }
+
+            if (rtcp_sink) {
+                gst_object_unref(rtcp_sink);
+                rtcp_sink = nullptr;
+            }
+            destinations.clear();
+            batched_egress = false;
+
+            if (tcp_server) {
+                gst_object_unref(tcp_server);
+                tcp_server = nullptr;
+            }
+            {
+                std::lock_guard<std::mutex> lock(tcp_clients_mutex);
+                for (GSocket *socket : tcp_clients) {
+                    g_object_unref(socket);
+                }
+                tcp_clients.clear();
+            }
+            bitrate_controller.reset();
+
+            if (encoder_options) {
+                gst_structure_free(encoder_options);
+                encoder_options = nullptr;
+            }
+
+            if (pipeline) {
+                gst_element_set_state(pipeline, GST_STATE_NULL);
+                gst_object_unref(pipeline);
+                pipeline = nullptr;
+            }
+
+            // Only now is no GstBuffer referencing slab memory
+            direct_pool.reset();
+
+            if (buffer_pool) {
+                LOGI("Buffer pool: %llu hits, %llu misses, grew by %d buffers",
+                     (unsigned long long) pool_hits.load(),
+                     (unsigned long long) pool_misses.load(),
+                     pool_allocations() - pool_preallocated);
+
+                gst_buffer_pool_set_active(buffer_pool, FALSE);
+                gst_object_unref(buffer_pool);
+                buffer_pool = nullptr;
+            }
+
+            is_initialized = false;
+            stopped = false;
+            LOGD("Cleanup complete");
         }
 
         /**
-         * Start the pipeline
+         * Snapshot of the pipeline counters
          */
-        bool start() {
-            if (!is_initialized) {
-                last_error = "Pipeline not initialized";
-                LOGE("%s", last_error.c_str());
-                return false;
+        void get_stats(PipelineStats &stats) const {
+            stats.pool_hits = pool_hits.load();
+            stats.pool_misses = pool_misses.load();
+            stats.pool_growth = buffer_pool ? (guint64) (pool_allocations() - pool_preallocated) : 0;
+            stats.ring_overruns = ring_overruns.load();
+            stats.ring_underruns = ring_underruns.load();
+            stats.discontinuities = discont_count.load();
+            stats.dropped_buffers = dropped_buffers.load();
+            stats.dropped_samples = dropped_samples.load();
+            stats.dropped_duration_ns = dropped_duration.load();
+            stats.encoder_bitrate = (guint64) encoder_bitrate.load();
+            stats.rtcp_fraction_lost = rtcp_fraction_lost.load();
+            stats.rtcp_jitter_us = rtcp_jitter_us.load();
+            stats.nacks_received = nacks_received.load();
+
+            if (rtx_sender) {
+                guint requests = 0, packets = 0;
+                g_object_get(G_OBJECT(rtx_sender),
+                    "num-rtx-requests", &requests,
+                    "num-rtx-packets", &packets,
+                    nullptr);
+                // A request that doesn't produce a packet fell out of history
+                stats.rtx_packets = packets;
+                stats.rtx_history_misses = requests > packets ? requests - packets : 0;
             }
 
-            LOGI("Starting pipeline");
+            if (batched_egress && rtp_sink) {
+                guint64 syscalls = 0, eagain = 0, enobufs = 0;
+                gdouble rate = 0;
+                g_object_get(G_OBJECT(rtp_sink),
+                    "syscalls", &syscalls,
+                    "syscalls-per-second", &rate,
+                    "send-eagain", &eagain,
+                    "send-enobufs", &enobufs,
+                    nullptr);
+                stats.egress_syscalls = syscalls;
+                stats.send_eagain = eagain;
+                stats.send_enobufs = enobufs;
+                stats.egress_syscalls_per_second = (guint64) (rate + 0.5);
+            }
 
-            GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
-            if (ret == GST_STATE_CHANGE_FAILURE) {
-                last_error = "Failed to start pipeline";
-                LOGE("%s", last_error.c_str());
+            stats.time_to_first_packet_us = time_to_first_packet_us.load();
+            stats.init_create_us = init_create_us;
+            stats.init_link_us = init_link_us;
+            stats.init_configure_us = init_configure_us;
+            stats.start_us = start_us;
+            stats.cold_start_us = cold_start_us.load();
+
+            if (aggregator) {
+                gdouble rate = 0, overhead = 0;
+                g_object_get(G_OBJECT(aggregator),
+                    "packet-rate", &rate,
+                    "overhead-ratio", &overhead,
+                    nullptr);
+                stats.rtp_packet_rate = (guint64) (rate + 0.5);
+                stats.rtp_overhead_permille = (guint64) (overhead * 1000 + 0.5);
+            }
+
+            if (tcp_server) {
+                std::lock_guard<std::mutex> lock(tcp_clients_mutex);
+                stats.tcp_clients = tcp_clients.size();
+                for (GSocket *socket : tcp_clients) {
+                    GstStructure *client_stats = nullptr;
+                    g_signal_emit_by_name(tcp_server, "get-stats", socket, &client_stats);
+                    if (client_stats) {
+                        stats.tcp_max_lag_ms = MAX(stats.tcp_max_lag_ms, (guint64) tcp_client_lag_ms(client_stats));
+                        gst_structure_free(client_stats);
+                    }
+                }
+            }
+        }
+
+        /**
+         * Start sending to another receiver, in place while streaming
+         */
+        bool add_destination(const std::string &host) {
+            std::lock_guard<std::mutex> lock(destinations_mutex);
+            if (!rtp_sink || host.empty()) {
                 return false;
             }
 
-            LOGI("Pipeline started successfully");
+            for (const std::string &destination : destinations) {
+                if (destination == host) {
+                    return true;
+                }
+            }
+
+            g_signal_emit_by_name(rtp_sink, "add", host.c_str(), _port);
+            g_signal_emit_by_name(rtcp_sink, "add", host.c_str(), _port + 1);
+            destinations.push_back(host);
+            LOGI("Added destination %s:%d (%zu total)", host.c_str(), _port, destinations.size());
             return true;
         }
 
         /**
-         * Feed audio data to the pipeline
-         * Following GStreamer best practice: use gst_app_src_push_buffer
+         * Stop sending to a receiver, in place while streaming
          */
-        bool push_data(const guint8 *data, gsize size) {
-            if (!is_initialized || !appsrc) {
+        bool remove_destination(const std::string &host) {
+            std::lock_guard<std::mutex> lock(destinations_mutex);
+            if (!rtp_sink) {
                 return false;
             }
 
-            // Create buffer and copy data
-            GstBuffer *buffer = gst_buffer_new_allocate(nullptr, size, nullptr);
-            if (!buffer) {
-                LOGE("Failed to allocate buffer");
-                return false;
+            for (auto it = destinations.begin(); it != destinations.end(); ++it) {
+                if (*it == host) {
+                    g_signal_emit_by_name(rtp_sink, "remove", host.c_str(), _port);
+                    g_signal_emit_by_name(rtcp_sink, "remove", host.c_str(), _port + 1);
+                    destinations.erase(it);
+                    LOGI("Removed destination %s:%d (%zu left)", host.c_str(), _port, destinations.size());
+                    return true;
+                }
             }
+            return false;
+        }
 
-            // Map and fill buffer
-            GstMapInfo map;
-            if (!gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
-                LOGE("Failed to map buffer");
-                gst_buffer_unref(buffer);
+        /**
+         * Move every receiver to a new port pair. Each client is added on the
+         * new port before it is removed from the old one, so no packet is lost
+         * in between.
+         */
+        bool set_port(gint port) {
+            std::lock_guard<std::mutex> lock(destinations_mutex);
+            if (!rtp_sink || port <= 0 || port >= 65535) {
                 return false;
             }
+            if (port == _port) {
+                return true;
+            }
 
-            memcpy(map.data, data, size);
-            gst_buffer_unmap(buffer, &map);
+            for (const std::string &host : destinations) {
+                g_signal_emit_by_name(rtp_sink, "add", host.c_str(), port);
+                g_signal_emit_by_name(rtcp_sink, "add", host.c_str(), port + 1);
+                g_signal_emit_by_name(rtp_sink, "remove", host.c_str(), _port);
+                g_signal_emit_by_name(rtcp_sink, "remove", host.c_str(), _port + 1);
+            }
+            LOGI("Destination port %d -> %d", _port, port);
+            _port = port;
+            return true;
+        }
 
-            // Push to appsrc
-            GstFlowReturn ret = gst_app_src_push_buffer(GST_APP_SRC(appsrc), buffer);
+        /**
+         * Switch to another encoder profile while streaming, FEC included
+         */
+        bool set_encoder_profile(const std::string &profile) {
+            std::lock_guard<std::mutex> lock(encoder_mutex);
+            if (!encoder) {
+                return false;
+            }
 
-            if (ret != GST_FLOW_OK) {
-                last_error = "Flow error: " + std::to_string(ret);
-                LOGW("Push buffer failed: %s", gst_flow_get_name(ret));
+            EncoderConfig config;
+            if (!config.load_preset(profile)) {
+                set_error("Unknown encoder profile: " + profile);
                 return false;
             }
+            if (encoder_options) {
+                config.apply_overrides(StructureOptions(encoder_options));
+            }
+
+            apply_encoder_config(config, encoder);
+            apply_fec_config(config, red_encoder, fec_encoder);
+            if (bitrate_controller) {
+                // Keep the loss estimate from receiver reports
+                g_object_set(G_OBJECT(encoder),
+                    "packet-loss-percentage", bitrate_controller->get_loss_percentage(),
+                    nullptr);
+            }
+            encoder_config = config;
 
+            LOGI("Encoder profile %s: %s", profile.c_str(), encoder_config.describe().c_str());
             return true;
         }
 
         /**
-         * Stop the pipeline gracefully
-         * Following GStreamer best practice: send EOS and wait for completion
+         * Address this device reaches host from, which is where a receiver
+         * sends its RTCP back to. Connecting a UDP socket only picks the
+         * route, nothing is sent. Empty when host isn't a literal address.
          */
-        void stop() {
-            if (!is_initialized) {
-                return;
+        static std::string local_address_for(const std::string &host) {
+            GInetAddress *remote = g_inet_address_new_from_string(host.c_str());
+            if (!remote) {
+                return "";
             }
 
-            LOGI("Stopping pipeline");
+            std::string local;
+            GSocket *socket = g_socket_new(g_inet_address_get_family(remote), G_SOCKET_TYPE_DATAGRAM,
+                                           G_SOCKET_PROTOCOL_UDP, nullptr);
+            GSocketAddress *address = g_inet_socket_address_new(remote, RTP_PORT);
+            if (socket && g_socket_connect(socket, address, nullptr, nullptr)) {
+                GSocketAddress *bound = g_socket_get_local_address(socket, nullptr);
+                if (bound) {
+                    gchar *text = g_inet_address_to_string(
+                        g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(bound)));
+                    local = text;
+                    g_free(text);
+                    g_object_unref(bound);
+                }
+            }
 
-            // Send EOS to appsrc for graceful shutdown
-            if (appsrc) {
-                gst_app_src_end_of_stream(GST_APP_SRC(appsrc));
+            if (socket) {
+                g_object_unref(socket);
             }
+            g_object_unref(address);
+            g_object_unref(remote);
+            return local;
+        }
 
-            // Wait for EOS message on the bus (with timeout)
-            if (pipeline) {
-                GstBus *bus = gst_pipeline_get_bus(GST_PIPELINE(pipeline));
-                GstMessage *msg = gst_bus_timed_pop_filtered(bus,
-                    3 * GST_SECOND,
-                    static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
-
-                if (msg) {
-                    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
-                        LOGW("Error during shutdown");
-                    }
-                    gst_message_unref(msg);
-                } else {
-                    LOGW("Timeout waiting for EOS");
+        /**
+         * gst-launch description of a receiver matching the current
+         * encoder profile: payload types, FEC decoding and jitter buffer,
+         * and the RTCP legs that carry sender reports in and receiver
+         * reports and NACKs back to this device
+         */
+        std::string get_receiver_pipeline() {
+            EncoderConfig config;
+            {
+                std::lock_guard<std::mutex> lock(encoder_mutex);
+                config = encoder_config;
+            }
+            gint port;
+            std::string group;
+            std::string destination;
+            {
+                std::lock_guard<std::mutex> lock(destinations_mutex);
+                port = _port;
+                group = multicast_group;
+                if (!destinations.empty()) {
+                    destination = destinations.front();
                 }
+            }
 
-                gst_object_unref(bus);
+            std::string sender = local_address_for(group.empty() ? destination : group);
+            if (sender.empty()) {
+                LOGW("No local address towards %s, fill in the sender's address for RTCP",
+                     destination.c_str());
+                sender = "SENDER_ADDRESS";
             }
 
-            // Set to NULL state
-            if (pipeline) {
-                gst_element_set_state(pipeline, GST_STATE_NULL);
+            std::string multicast;
+            if (!group.empty()) {
+                multicast = "address=" + group + " auto-multicast=true ";
+            }
+
+            std::string source = "udpsrc port=" + std::to_string(port) + " " + multicast;
+            source += "caps=\"application/x-rtp, media=(string)audio, clock-rate=(int)48000, "
+                "encoding-name=(string)OPUS, payload=(int)" + std::to_string(OPUS_PAYLOAD_TYPE) + "\" ";
+
+            std::string session = "rtpbin name=rtpbin latency=" +
+                std::to_string(RECEIVER_LATENCY_MS + config.fec_latency_ms()) + " ";
+            if (rtx_sender) {
+                // Retransmissions arrive on their own SSRC, and rtprtxreceive
+                // only matches them up once it has seen the jitter buffer's
+                // requests, which it does only behind the session, as the
+                // aux receiver from request-aux-receiver. gst-launch can't
+                // connect that signal, and without it do-retransmission would
+                // leave each retransmission stream on an unlinked pad.
+                LOGW("RTX needs a programmatic receiver: rtpbin rtp-profile=avpf "
+                     "do-retransmission=true with an rtprtxreceive from request-aux-receiver, "
+                     "payload-type-map=\"application/x-rtp-pt-map, %d=(uint)%d, %d=(uint)%d\"",
+                     OPUS_PAYLOAD_TYPE, OPUS_RTX_PAYLOAD_TYPE, RED_PAYLOAD_TYPE, RED_RTX_PAYLOAD_TYPE);
+            }
+
+            if (config.fec == "red") {
+                source += "! rtpreddec pt=" + std::to_string(RED_PAYLOAD_TYPE) + " ";
+            } else if (config.fec == "ulpfec") {
+                session += "fec-decoders='fec,0=\"rtpulpfecdec\\ pt\\=" +
+                    std::to_string(ULPFEC_PAYLOAD_TYPE) + "\";' ";
             }
 
-            LOGI("Pipeline stopped");
+            std::string rtcp = "udpsrc port=" + std::to_string(port + 1) + " " + multicast +
+                "! rtpbin.recv_rtcp_sink_0 "
+                "rtpbin.send_rtcp_src_0 ! udpsink host=" + sender + " port=" + std::to_string(_rtcp_port) +
+                " sync=false async=false ";
+
+            return session + source + "! rtpbin.recv_rtp_sink_0 " + rtcp +
+                "rtpbin. ! rtpopusdepay ! opusdec plc=true ! audioconvert ! autoaudiosink";
         }
 
         /**
-         * Cleanup all resources
-         * Following RAII principles for resource management
+         * One line per TCP client: address, lag, bytes sent, dropped buffers
          */
-        void cleanup() {
-            LOGD("Cleaning up pipeline");
-
-            if (bus_watch_id > 0) {
-                g_source_remove(bus_watch_id);
-                bus_watch_id = 0;
+        std::string get_client_report() const {
+            std::string report;
+            if (!tcp_server) {
+                return report;
             }
 
-            if (appsrc) {
-                gst_object_unref(appsrc);
-                appsrc = nullptr;
-            }
+            std::lock_guard<std::mutex> lock(tcp_clients_mutex);
+            for (GSocket *socket : tcp_clients) {
+                GstStructure *client_stats = nullptr;
+                g_signal_emit_by_name(tcp_server, "get-stats", socket, &client_stats);
+                if (!client_stats) {
+                    continue;
+                }
 
-            if (pipeline) {
-                gst_object_unref(pipeline);
-                pipeline = nullptr;
+                std::string address = "unknown";
+                GSocketAddress *remote = g_socket_get_remote_address(socket, nullptr);
+                if (remote) {
+                    if (G_IS_INET_SOCKET_ADDRESS(remote)) {
+                        gchar *ip = g_inet_address_to_string(
+                            g_inet_socket_address_get_address(G_INET_SOCKET_ADDRESS(remote)));
+                        address = std::string(ip) + ":" +
+                            std::to_string(g_inet_socket_address_get_port(G_INET_SOCKET_ADDRESS(remote)));
+                        g_free(ip);
+                    }
+                    g_object_unref(remote);
+                }
+
+                guint64 bytes_sent = 0, dropped = 0;
+                gst_structure_get_uint64(client_stats, "bytes-sent", &bytes_sent);
+                gst_structure_get_uint64(client_stats, "buffers-dropped", &dropped);
+
+                report += address + " lag=" + std::to_string(tcp_client_lag_ms(client_stats)) + "ms"
+                    " sent=" + std::to_string(bytes_sent) + "B dropped=" + std::to_string(dropped) + "\n";
+                gst_structure_free(client_stats);
             }
+            return report;
+        }
 
-            is_initialized = false;
-            LOGD("Cleanup complete");
+        /**
+         * Which conversion path init chose and why
+         */
+        std::string get_pipeline_report() const {
+            return pipeline_report;
         }
 
         /**
          * Get last error message
          */
         std::string get_last_error() const {
+            std::lock_guard<std::mutex> lock(error_mutex);
             return last_error;
         }
 
@@ -323,8 +3516,135 @@ class AudioPipeline {
         }
 };
 
-// Global pipeline instance
-static std::unique_ptr<AudioPipeline> g_pipeline;
+/**
+ * Owns the running sessions, each an AudioPipeline behind an opaque handle
+ *
+ * JNI calls look their session up and work on their own reference, so an
+ * asynchronous stop can take a session away at any time. Handles are never
+ * reused: a stale one simply finds nothing. Every session runs on the same
+ * clock and base time, so their running times are comparable and a mirror
+ * session can take the timestamps of the session it mirrors.
+ */
+class SessionManager {
+    private:
+        std::unordered_map<jlong, std::shared_ptr<AudioPipeline>> sessions;
+        jlong next_handle = 1;
+        GstClock *clock = nullptr;
+        GstClockTime base_time = GST_CLOCK_TIME_NONE;
+        std::string init_error;
+        mutable std::mutex mutex;
+
+    public:
+        /**
+         * Take an initialized pipeline; returns its handle
+         */
+        jlong add(const std::shared_ptr<AudioPipeline> &session) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!clock) {
+                clock = gst_system_clock_obtain();
+                base_time = gst_clock_get_time(clock);
+            }
+
+            jlong handle = next_handle++;
+            session->set_session_handle(handle);
+            session->use_clock(clock, base_time);
+            sessions[handle] = session;
+
+            LOGI("Session %lld added, %zu running", (long long) handle, sessions.size());
+            return handle;
+        }
+
+        std::shared_ptr<AudioPipeline> find(jlong handle) const {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = sessions.find(handle);
+            return it != sessions.end() ? it->second : nullptr;
+        }
+
+        /**
+         * Detach a session. It stops being fed from any session it mirrors,
+         * and its own mirrors are released so one of them can take over the
+         * capture.
+         */
+        std::shared_ptr<AudioPipeline> remove(jlong handle) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = sessions.find(handle);
+            if (it == sessions.end()) {
+                return nullptr;
+            }
+
+            std::shared_ptr<AudioPipeline> session = std::move(it->second);
+            sessions.erase(it);
+            session->clear_mirrors();
+            for (auto &entry : sessions) {
+                entry.second->remove_mirror(session.get());
+            }
+
+            LOGI("Session %lld removed, %zu running", (long long) handle, sessions.size());
+            return session;
+        }
+
+        size_t count() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return sessions.size();
+        }
+
+        /**
+         * Why the last init failed; there is no session to ask
+         */
+        void set_init_error(const std::string &error) {
+            std::lock_guard<std::mutex> lock(mutex);
+            init_error = error;
+        }
+
+        std::string get_init_error() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            return init_error;
+        }
+};
+
+static SessionManager g_sessions;
+
+// Stops still draining on worker threads
+static std::mutex g_stops_mutex;
+static guint g_pending_stops = 0;
+// Local ports still held by those stops, with how many hold each
+static std::unordered_map<gint, guint> g_stopping_ports;
+// Listener references of stop workers that couldn't attach to the VM,
+// released by the next JNI call
+static std::vector<jobject> g_orphaned_refs;
+
+// AudioCaptureService.onPipelineStopped(long session, boolean drained, long elapsedUs),
+// looked up in JNI_OnLoad since stop workers run on native threads
+static jmethodID g_on_pipeline_stopped = nullptr;
+
+static guint pending_stops() {
+    std::lock_guard<std::mutex> lock(g_stops_mutex);
+    return g_pending_stops;
+}
+
+/**
+ * First of the given ports a draining stop still holds, or 0
+ */
+static gint stopping_port(const std::vector<gint> &ports) {
+    std::lock_guard<std::mutex> lock(g_stops_mutex);
+    for (gint port : ports) {
+        if (g_stopping_ports.count(port)) {
+            return port;
+        }
+    }
+    return 0;
+}
+
+static void release_orphaned_refs(JNIEnv *env) {
+    std::vector<jobject> refs;
+    {
+        std::lock_guard<std::mutex> lock(g_stops_mutex);
+        refs.swap(g_orphaned_refs);
+    }
+    for (jobject ref : refs) {
+        env->DeleteGlobalRef(ref);
+    }
+}
 
 // Forward declaration - implemented in gstreamer-info.cpp
 extern "C" jint register_gstreamer_methods(JNIEnv *env);
@@ -334,62 +3654,143 @@ extern "C" jint register_gstreamer_methods(JNIEnv *env);
 // ============================================================================
 
 /**
- * Initialize the GStreamer audio pipeline
+ * Initialize a new session's pipeline
+ * Returns the session handle, or 0 when init failed
  */
-static jboolean native_init_pipeline(JNIEnv *env, jobject thiz,
+static jlong native_init_pipeline(JNIEnv *env, jobject thiz,
                                       jstring host,
                                       jint sample_rate, jint channels,
-                                      jstring output_path, jint bitrate) {
+                                      jstring format,
+                                      jstring output_path, jint bitrate,
+                                      jint period_size, jstring options) {
     // Get host string
     const char *host_str = env->GetStringUTFChars(host, nullptr);
     if (!host_str) {
         LOGE("Failed to get host string");
-        return JNI_FALSE;
+        return 0;
+    }
+
+    // Get sample format string
+    const char *format_str = env->GetStringUTFChars(format, nullptr);
+    if (!format_str) {
+        LOGE("Failed to get format string");
+        env->ReleaseStringUTFChars(host, host_str);
+        return 0;
     }
+    std::string format_value(format_str);
+    env->ReleaseStringUTFChars(format, format_str);
 
     // Get output path string
     const char *path_str = env->GetStringUTFChars(output_path, nullptr);
     if (!path_str) {
         LOGE("Failed to get output path string");
         env->ReleaseStringUTFChars(host, host_str);
-        return JNI_FALSE;
+        return 0;
+    }
+
+    // Parse pipeline options, serialized as a GstStructure
+    GstStructure *options_struct = nullptr;
+    if (options) {
+        const char *options_str = env->GetStringUTFChars(options, nullptr);
+        if (options_str && *options_str) {
+            options_struct = gst_structure_from_string(options_str, nullptr);
+            if (!options_struct) {
+                LOGE("Invalid pipeline options: %s", options_str);
+                g_sessions.set_init_error("Invalid pipeline options");
+                env->ReleaseStringUTFChars(options, options_str);
+                env->ReleaseStringUTFChars(host, host_str);
+                env->ReleaseStringUTFChars(output_path, path_str);
+                return 0;
+            }
+        }
+        if (options_str) {
+            env->ReleaseStringUTFChars(options, options_str);
+        }
     }
 
-    // Create new pipeline
-    g_pipeline = std::make_unique<AudioPipeline>();
+    // A session still draining may hold a port the new one binds. Init
+    // runs on the service's main thread, so rather than wait for it fail at
+    // once; Java retries from onPipelineStopped. Sessions on other ports
+    // aren't held up.
+    gint busy_port = stopping_port(AudioPipeline::bound_ports(options_struct));
+    if (busy_port != 0) {
+        LOGW("Port %d still held by a stopping pipeline, not initializing", busy_port);
+        g_sessions.set_init_error("Port " + std::to_string(busy_port) + " still held by a stopping pipeline");
+        env->ReleaseStringUTFChars(host, host_str);
+        env->ReleaseStringUTFChars(output_path, path_str);
+        if (options_struct) {
+            gst_structure_free(options_struct);
+        }
+        return 0;
+    }
 
-    // Initialize
-    bool result = g_pipeline->init(host_str, sample_rate, channels, path_str, bitrate);
+    // Create and initialize the new pipeline
+    std::shared_ptr<AudioPipeline> pipeline = std::make_shared<AudioPipeline>();
+    bool result = pipeline->init(env, host_str, sample_rate, channels, format_value, path_str, bitrate,
+                                 static_cast<gsize>(period_size > 0 ? period_size : 0),
+                                 options_struct, thiz);
 
     // Release strings
     env->ReleaseStringUTFChars(host, host_str);
     env->ReleaseStringUTFChars(output_path, path_str);
+    if (options_struct) {
+        gst_structure_free(options_struct);
+    }
 
     if (!result) {
-        g_pipeline.reset();
+        g_sessions.set_init_error(pipeline->get_last_error());
+        return 0;
     }
 
-    return result ? JNI_TRUE : JNI_FALSE;
+    return g_sessions.add(pipeline);
 }
 
 /**
  * Start the GStreamer pipeline
  */
-static jboolean native_start_pipeline(JNIEnv *env, jobject thiz) {
-    if (!g_pipeline) {
-        LOGE("Pipeline not initialized");
+static jboolean native_start_pipeline(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    return pipeline->start() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Put the pipeline in warm standby
+ */
+static jboolean native_pause(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    return pipeline->pause() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Resume streaming from warm standby
+ */
+static jboolean native_resume(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
         return JNI_FALSE;
     }
 
-    return g_pipeline->start() ? JNI_TRUE : JNI_FALSE;
+    return pipeline->resume() ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
  * Feed audio data to the pipeline
  */
-static jboolean native_feed_audio_data(JNIEnv *env, jobject thiz,
+static jboolean native_feed_audio_data(JNIEnv *env, jobject thiz, jlong session,
                                         jbyteArray buffer, jint size) {
-    if (!g_pipeline) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
         return JNI_TRUE; // Silently ignore if no pipeline
     }
 
@@ -401,7 +3802,7 @@ static jboolean native_feed_audio_data(JNIEnv *env, jobject thiz,
     }
 
     // Push data to pipeline
-    bool result = g_pipeline->push_data(
+    bool result = pipeline->push_data(
         reinterpret_cast<const guint8*>(buffer_data),
         static_cast<gsize>(size)
     );
@@ -413,27 +3814,377 @@ static jboolean native_feed_audio_data(JNIEnv *env, jobject thiz,
 }
 
 /**
- * Stop the GStreamer pipeline
+ * Feed audio data from a direct ByteBuffer
+ * Zero copy when the buffer was obtained from nativeAcquireDirectBuffer
  */
-static void native_stop_pipeline(JNIEnv *env, jobject thiz) {
-    if (g_pipeline) {
-        g_pipeline->stop();
-        g_pipeline.reset();
+static jboolean native_feed_direct_buffer(JNIEnv *env, jobject thiz, jlong session,
+                                           jobject buffer, jint size) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return JNI_TRUE; // Silently ignore if no pipeline
     }
+
+    void *address = env->GetDirectBufferAddress(buffer);
+    if (!address) {
+        LOGE("Buffer is not a direct ByteBuffer");
+        return JNI_FALSE;
+    }
+
+    bool result = pipeline->push_direct(
+        static_cast<guint8*>(address),
+        static_cast<gsize>(size > 0 ? size : 0)
+    );
+
+    return result ? JNI_TRUE : JNI_FALSE;
 }
 
 /**
- * Get last error message
+ * Feed several periods from one direct ByteBuffer as a single buffer list
  */
-static jstring native_get_last_error(JNIEnv *env, jobject thiz) {
-    if (!g_pipeline) {
-        return env->NewStringUTF("Pipeline not initialized");
+static jboolean native_feed_direct_batch(JNIEnv *env, jobject thiz, jlong session,
+                                          jobject buffer, jint size, jint period_size) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return JNI_TRUE; // Silently ignore if no pipeline
+    }
+
+    void *address = env->GetDirectBufferAddress(buffer);
+    if (!address) {
+        LOGE("Buffer is not a direct ByteBuffer");
+        return JNI_FALSE;
+    }
+
+    bool result = pipeline->push_direct_batch(
+        static_cast<guint8*>(address),
+        static_cast<gsize>(size > 0 ? size : 0),
+        static_cast<gsize>(period_size > 0 ? period_size : 0)
+    );
+
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Lend a pooled native slab to Java as a direct ByteBuffer
+ * Returns null when no slab is free; the caller then uses its own buffer
+ */
+static jobject native_acquire_direct_buffer(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return nullptr;
+    }
+
+    jobject byte_buffer = pipeline->acquire_direct_buffer();
+    return byte_buffer ? env->NewLocalRef(byte_buffer) : nullptr;
+}
+
+/**
+ * Drain and stop a pipeline off the caller's thread, then report to Java
+ *
+ * A watchdog forces the pipeline to NULL once the deadline passes, which
+ * unblocks a wedged sink or an appsrc blocked on a full queue so the drain
+ * can finish. The pipeline is destroyed on this thread while it is
+ * attached to the VM, so its direct buffer references can be released.
+ */
+static void stop_worker(jlong session, std::shared_ptr<AudioPipeline> pipeline, jobject target, GstClockTime deadline) {
+    pthread_setname_np(pthread_self(), "pipeline-stop");
+
+    JNIEnv *env = nullptr;
+    bool attached = g_jvm && g_jvm->AttachCurrentThread(&env, nullptr) == JNI_OK;
+    gint64 begin = g_get_monotonic_time();
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+
+    std::thread watchdog([&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!cv.wait_for(lock, std::chrono::nanoseconds(deadline), [&] { return done; })) {
+            lock.unlock();
+            LOGW("Stop deadline of %llums passed", (unsigned long long) (deadline / GST_MSECOND));
+            pipeline->force_stop();
+        }
+    });
+
+    bool drained = pipeline->stop(deadline);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+    }
+    cv.notify_one();
+    watchdog.join();
+
+    std::vector<gint> ports = pipeline->get_local_ports();
+    pipeline.reset();
+    gint64 elapsed = g_get_monotonic_time() - begin;
+    LOGI("Session %lld stopped in %.2fms (%s)", (long long) session, elapsed / 1000.0, drained ? "drained" : "forced");
+
+    {
+        std::lock_guard<std::mutex> lock(g_stops_mutex);
+        g_pending_stops--;
+        for (gint port : ports) {
+            auto it = g_stopping_ports.find(port);
+            if (it != g_stopping_ports.end() && --it->second == 0) {
+                g_stopping_ports.erase(it);
+            }
+        }
+        if (!attached) {
+            // Java never hears about this stop; it polls nativeGetPendingStops
+            LOGW("Stop worker not attached to the VM, onPipelineStopped not called");
+            g_orphaned_refs.push_back(target);
+        }
+    }
+
+    if (attached) {
+        env->CallVoidMethod(target, g_on_pipeline_stopped, session, (jboolean) drained, (jlong) elapsed);
+        if (env->ExceptionCheck()) {
+            env->ExceptionDescribe();
+            env->ExceptionClear();
+        }
+        env->DeleteGlobalRef(target);
+        g_jvm->DetachCurrentThread();
+    }
+}
+
+/**
+ * Stop a session without blocking the caller
+ *
+ * The session is removed right away, so later calls with its handle find
+ * nothing, and drained on a worker thread. AudioCaptureService.onPipelineStopped
+ * is called once it is gone. Returns false when there was nothing to stop.
+ */
+static jboolean native_stop_pipeline_async(JNIEnv *env, jobject thiz, jlong session, jint deadline_ms) {
+    release_orphaned_refs(env);
+
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.remove(session);
+    if (!pipeline) {
+        return JNI_FALSE;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_stops_mutex);
+        g_pending_stops++;
+        for (gint port : pipeline->get_local_ports()) {
+            g_stopping_ports[port]++;
+        }
+    }
+
+    GstClockTime deadline = (GstClockTime) (deadline_ms > 0 ? deadline_ms : DEFAULT_STOP_DEADLINE_MS) * GST_MSECOND;
+    std::thread(stop_worker, session, std::move(pipeline), env->NewGlobalRef(thiz), deadline).detach();
+    return JNI_TRUE;
+}
+
+/**
+ * Number of stops still draining. Always current, even when a stop worker
+ * couldn't deliver onPipelineStopped.
+ */
+static jint native_get_pending_stops(JNIEnv *env, jobject thiz) {
+    release_orphaned_refs(env);
+    return (jint) pending_stops();
+}
+
+/**
+ * Get last error message; with no such session, why the last init failed
+ */
+static jstring native_get_last_error(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        // No session means init failed, or the handle is stale
+        std::string error = g_sessions.get_init_error();
+        return env->NewStringUTF(error.empty() ? "Pipeline not initialized" : error.c_str());
     }
 
-    std::string error = g_pipeline->get_last_error();
+    std::string error = pipeline->get_last_error();
     return env->NewStringUTF(error.c_str());
 }
 
+/**
+ * Get the pipeline counters, in PipelineStats field order
+ */
+static jlongArray native_get_stats(JNIEnv *env, jobject thiz, jlong session) {
+    PipelineStats stats;
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (pipeline) {
+        pipeline->get_stats(stats);
+    }
+
+    jlong values[] = {
+        (jlong) stats.pool_hits,
+        (jlong) stats.pool_misses,
+        (jlong) stats.pool_growth,
+        (jlong) stats.ring_overruns,
+        (jlong) stats.ring_underruns,
+        (jlong) stats.discontinuities,
+        (jlong) stats.dropped_buffers,
+        (jlong) stats.dropped_samples,
+        (jlong) stats.dropped_duration_ns,
+        (jlong) stats.encoder_bitrate,
+        (jlong) stats.rtcp_fraction_lost,
+        (jlong) stats.rtcp_jitter_us,
+        (jlong) stats.nacks_received,
+        (jlong) stats.rtx_packets,
+        (jlong) stats.rtx_history_misses,
+        (jlong) stats.egress_syscalls,
+        (jlong) stats.egress_syscalls_per_second,
+        (jlong) stats.tcp_clients,
+        (jlong) stats.tcp_max_lag_ms,
+        (jlong) stats.send_eagain,
+        (jlong) stats.send_enobufs,
+        (jlong) stats.rtp_packet_rate,
+        (jlong) stats.rtp_overhead_permille,
+        (jlong) stats.time_to_first_packet_us,
+        (jlong) stats.init_create_us,
+        (jlong) stats.init_link_us,
+        (jlong) stats.init_configure_us,
+        (jlong) stats.start_us,
+        (jlong) stats.cold_start_us,
+    };
+
+    jlongArray result = env->NewLongArray(G_N_ELEMENTS(values));
+    if (result) {
+        env->SetLongArrayRegion(result, 0, G_N_ELEMENTS(values), values);
+    }
+    return result;
+}
+
+/**
+ * Feed a second session from this session's capture
+ */
+static jboolean native_add_mirror(JNIEnv *env, jobject thiz, jlong session, jlong mirror) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    std::shared_ptr<AudioPipeline> mirror_pipeline = g_sessions.find(mirror);
+    if (!pipeline || !mirror_pipeline) {
+        LOGE("No session %lld", (long long) (pipeline ? mirror : session));
+        return JNI_FALSE;
+    }
+
+    return pipeline->add_mirror(mirror_pipeline) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Number of running sessions
+ */
+static jint native_get_session_count(JNIEnv *env, jobject thiz) {
+    return (jint) g_sessions.count();
+}
+
+/**
+ * Add a receiver to the running stream
+ */
+static jboolean native_add_destination(JNIEnv *env, jobject thiz, jlong session, jstring host) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    const char *host_str = env->GetStringUTFChars(host, nullptr);
+    if (!host_str) {
+        LOGE("Failed to get host string");
+        return JNI_FALSE;
+    }
+
+    bool result = pipeline->add_destination(host_str);
+    env->ReleaseStringUTFChars(host, host_str);
+
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Remove a receiver from the running stream
+ */
+static jboolean native_remove_destination(JNIEnv *env, jobject thiz, jlong session, jstring host) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    const char *host_str = env->GetStringUTFChars(host, nullptr);
+    if (!host_str) {
+        LOGE("Failed to get host string");
+        return JNI_FALSE;
+    }
+
+    bool result = pipeline->remove_destination(host_str);
+    env->ReleaseStringUTFChars(host, host_str);
+
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Move all receivers to another RTP port (RTCP follows on port + 1)
+ */
+static jboolean native_set_port(JNIEnv *env, jobject thiz, jlong session, jint port) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    return pipeline->set_port(port) ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Switch encoder profile on the running pipeline
+ */
+static jboolean native_set_encoder_profile(JNIEnv *env, jobject thiz, jlong session, jstring profile) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        LOGE("No session %lld", (long long) session);
+        return JNI_FALSE;
+    }
+
+    const char *profile_str = env->GetStringUTFChars(profile, nullptr);
+    if (!profile_str) {
+        LOGE("Failed to get profile string");
+        return JNI_FALSE;
+    }
+
+    bool result = pipeline->set_encoder_profile(profile_str);
+    env->ReleaseStringUTFChars(profile, profile_str);
+
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Receiver pipeline matching the current encoder profile
+ */
+static jstring native_get_receiver_pipeline(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return env->NewStringUTF("");
+    }
+
+    std::string receiver = pipeline->get_receiver_pipeline();
+    return env->NewStringUTF(receiver.c_str());
+}
+
+/**
+ * Per-client report for the TCP server
+ */
+static jstring native_get_client_report(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return env->NewStringUTF("");
+    }
+
+    std::string report = pipeline->get_client_report();
+    return env->NewStringUTF(report.c_str());
+}
+
+/**
+ * Get the pipeline path report
+ */
+static jstring native_get_pipeline_report(JNIEnv *env, jobject thiz, jlong session) {
+    std::shared_ptr<AudioPipeline> pipeline = g_sessions.find(session);
+    if (!pipeline) {
+        return env->NewStringUTF("Pipeline not initialized");
+    }
+
+    std::string report = pipeline->get_pipeline_report();
+    return env->NewStringUTF(report.c_str());
+}
+
 // ============================================================================
 // JNI Method Registration
 // ============================================================================
@@ -442,11 +4193,27 @@ static jstring native_get_last_error(JNIEnv *env, jobject thiz) {
  * Native method table for AudioCaptureService
  */
 static JNINativeMethod native_methods[] = {
-    {"nativeInitPipeline", "(Ljava/lang/String;IILjava/lang/String;I)Z", (void *) native_init_pipeline},
-    {"nativeStartPipeline", "()Z", (void *) native_start_pipeline},
-    {"nativeFeedAudioData", "([BI)Z", (void *) native_feed_audio_data},
-    {"nativeStopPipeline", "()V", (void *) native_stop_pipeline},
-    {"nativeGetLastError", "()Ljava/lang/String;", (void *) native_get_last_error}
+    {"nativeInitPipeline", "(Ljava/lang/String;IILjava/lang/String;Ljava/lang/String;IILjava/lang/String;)J", (void *) native_init_pipeline},
+    {"nativeStartPipeline", "(J)Z", (void *) native_start_pipeline},
+    {"nativePause", "(J)Z", (void *) native_pause},
+    {"nativeResume", "(J)Z", (void *) native_resume},
+    {"nativeFeedAudioData", "(J[BI)Z", (void *) native_feed_audio_data},
+    {"nativeFeedDirectBuffer", "(JLjava/nio/ByteBuffer;I)Z", (void *) native_feed_direct_buffer},
+    {"nativeFeedDirectBatch", "(JLjava/nio/ByteBuffer;II)Z", (void *) native_feed_direct_batch},
+    {"nativeAcquireDirectBuffer", "(J)Ljava/nio/ByteBuffer;", (void *) native_acquire_direct_buffer},
+    {"nativeStopPipelineAsync", "(JI)Z", (void *) native_stop_pipeline_async},
+    {"nativeGetLastError", "(J)Ljava/lang/String;", (void *) native_get_last_error},
+    {"nativeGetPipelineReport", "(J)Ljava/lang/String;", (void *) native_get_pipeline_report},
+    {"nativeAddDestination", "(JLjava/lang/String;)Z", (void *) native_add_destination},
+    {"nativeRemoveDestination", "(JLjava/lang/String;)Z", (void *) native_remove_destination},
+    {"nativeSetPort", "(JI)Z", (void *) native_set_port},
+    {"nativeSetEncoderProfile", "(JLjava/lang/String;)Z", (void *) native_set_encoder_profile},
+    {"nativeGetReceiverPipeline", "(J)Ljava/lang/String;", (void *) native_get_receiver_pipeline},
+    {"nativeGetClientReport", "(J)Ljava/lang/String;", (void *) native_get_client_report},
+    {"nativeGetStats", "(J)[J", (void *) native_get_stats},
+    {"nativeAddMirror", "(JJ)Z", (void *) native_add_mirror},
+    {"nativeGetSessionCount", "()I", (void *) native_get_session_count},
+    {"nativeGetPendingStops", "()I", (void *) native_get_pending_stops}
 };
 
 /**
@@ -455,6 +4222,7 @@ static JNINativeMethod native_methods[] = {
  */
 JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     JNIEnv *env = nullptr;
+    g_jvm = vm;
 
     if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
         LOGE("Failed to get JNI environment");
@@ -473,6 +4241,18 @@ JNIEXPORT jint JNI_OnLoad(JavaVM *vm, void *reserved) {
         return JNI_ERR;
     }
 
+    // Cached for stop workers and bus threads, which can't look them up
+    // from a native thread
+    g_on_pipeline_stopped = env->GetMethodID(audio_service_class, "onPipelineStopped", "(JZJ)V");
+    g_on_pipeline_events = env->GetMethodID(audio_service_class, "onPipelineEvents", "(J[I[Ljava/lang/String;)V");
+    jclass string_class = env->FindClass("java/lang/String");
+    if (!g_on_pipeline_stopped || !g_on_pipeline_events || !string_class) {
+        LOGE("Failed to find AudioCaptureService callbacks");
+        return JNI_ERR;
+    }
+    g_string_class = static_cast<jclass>(env->NewGlobalRef(string_class));
+    env->DeleteLocalRef(string_class);
+
     LOGI("AudioCaptureService native methods registered successfully");
 
     // Register GStreamer class methods (implemented in gstreamer-info.cpp)
@@ -0,0 +1,414 @@
+#include <vector>
+#include <android/log.h>
+#include <gst/gst.h>
+#include <opus.h>
+
+#define LOG_TAG "OpusAggregator"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+// Opus packets carry at most 120 ms of audio (RFC 6716 section 3.2.5)
+#define OPUS_MAX_PACKET_DURATION (120 * GST_MSECOND)
+
+// IPv4 + UDP + RTP fixed headers, the per-packet cost aggregation amortizes
+#define PACKET_HEADER_BYTES (20 + 8 + 12)
+
+#define DEFAULT_PTIME 0
+#define DEFAULT_MAX_PTIME OPUS_MAX_PACKET_DURATION
+#define DEFAULT_MTU 1400
+
+/**
+ * Encoded frame held until its packet is complete
+ */
+struct HeldFrame {
+    GstBuffer *buffer;
+    GstMapInfo map;
+    GstClockTime duration;
+};
+
+/**
+ * OpusAggregator - joins consecutive Opus packets into one (RFC 6716 code 3)
+ *
+ * Sits between opusenc and rtpopuspay. Frames are collected until ptime of
+ * audio is held, then merged with libopus' repacketizer so one RTP packet
+ * carries several frames. A packet is closed early when the next frame
+ * would pass max-ptime, would not fit in the MTU, or uses a different
+ * Opus mode or bandwidth (which can't share a packet). ptime 0 passes
+ * frames through untouched.
+ */
+struct OpusAggregator {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    OpusRepacketizer *repacketizer;
+    std::vector<HeldFrame> *held;
+    GstClockTime held_duration;
+    gsize held_bytes;
+
+    guint64 ptime;
+    guint64 max_ptime;
+    guint mtu;
+
+    GMutex stats_lock;
+    guint64 packets;
+    guint64 payload_bytes;
+    gint64 window_start_us;
+    guint64 window_packets;
+    gdouble packet_rate;
+};
+
+struct OpusAggregatorClass {
+    GstElementClass parent_class;
+};
+
+enum {
+    PROP_0,
+    PROP_PTIME,
+    PROP_MAX_PTIME,
+    PROP_MTU,
+    PROP_PACKETS,
+    PROP_PAYLOAD_BYTES,
+    PROP_PACKET_RATE,
+    PROP_OVERHEAD_RATIO,
+};
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE("sink",
+    GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS("audio/x-opus"));
+
+static GstStaticPadTemplate src_template = GST_STATIC_PAD_TEMPLATE("src",
+    GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS("audio/x-opus"));
+
+G_DEFINE_TYPE(OpusAggregator, opus_aggregator, GST_TYPE_ELEMENT)
+
+#define OPUS_AGGREGATOR(obj) (reinterpret_cast<OpusAggregator*>(obj))
+
+static void release_held(OpusAggregator *self) {
+    for (HeldFrame &frame : *self->held) {
+        gst_buffer_unmap(frame.buffer, &frame.map);
+        gst_buffer_unref(frame.buffer);
+    }
+    self->held->clear();
+    self->held_duration = 0;
+    self->held_bytes = 0;
+    opus_repacketizer_init(self->repacketizer);
+}
+
+static void count_packet(OpusAggregator *self, gsize size) {
+    g_mutex_lock(&self->stats_lock);
+    self->packets++;
+    self->payload_bytes += size;
+    self->window_packets++;
+
+    gint64 now = g_get_monotonic_time();
+    if (self->window_start_us == 0) {
+        self->window_start_us = now;
+    } else if (now - self->window_start_us >= G_USEC_PER_SEC) {
+        self->packet_rate = self->window_packets * (gdouble) G_USEC_PER_SEC / (now - self->window_start_us);
+        self->window_packets = 0;
+        self->window_start_us = now;
+    }
+    g_mutex_unlock(&self->stats_lock);
+}
+
+/**
+ * Push everything held as one packet
+ */
+static GstFlowReturn flush_held(OpusAggregator *self) {
+    if (self->held->empty()) {
+        return GST_FLOW_OK;
+    }
+
+    GstBuffer *out;
+    if (self->held->size() == 1) {
+        // Nothing to merge, send the encoder's packet as is
+        out = gst_buffer_ref(self->held->front().buffer);
+    } else {
+        gsize max_size = self->held_bytes + 2 + 2 * self->held->size();
+        out = gst_buffer_new_allocate(nullptr, max_size, nullptr);
+
+        GstMapInfo map;
+        gst_buffer_map(out, &map, GST_MAP_WRITE);
+        opus_int32 size = opus_repacketizer_out(self->repacketizer, map.data, map.size);
+        gst_buffer_unmap(out, &map);
+
+        if (size < 0) {
+            LOGW("Repacketizing %zu frames failed: %s", self->held->size(), opus_strerror(size));
+            gst_buffer_unref(out);
+            release_held(self);
+            return GST_FLOW_OK;
+        }
+        gst_buffer_set_size(out, size);
+
+        GstBuffer *first = self->held->front().buffer;
+        gst_buffer_copy_into(out, first, GST_BUFFER_COPY_METADATA, 0, -1);
+        GST_BUFFER_DURATION(out) = self->held_duration;
+    }
+
+    release_held(self);
+    count_packet(self, gst_buffer_get_size(out));
+    return gst_pad_push(self->srcpad, out);
+}
+
+static GstFlowReturn opus_aggregator_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer) {
+    OpusAggregator *self = OPUS_AGGREGATOR(parent);
+
+    if (self->ptime == 0 && self->held->empty()) {
+        count_packet(self, gst_buffer_get_size(buffer));
+        return gst_pad_push(self->srcpad, buffer);
+    }
+
+    HeldFrame frame;
+    frame.buffer = buffer;
+    if (!gst_buffer_map(buffer, &frame.map, GST_MAP_READ)) {
+        gst_buffer_unref(buffer);
+        return GST_FLOW_ERROR;
+    }
+
+    gint samples = opus_packet_get_nb_samples(frame.map.data, frame.map.size, 48000);
+    frame.duration = samples > 0 ? gst_util_uint64_scale_int(samples, GST_SECOND, 48000) : GST_BUFFER_DURATION(buffer);
+    if (!GST_CLOCK_TIME_IS_VALID(frame.duration)) {
+        frame.duration = 0;
+    }
+
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    // Close the current packet if this frame can't join it
+    gsize payload_limit = self->mtu > PACKET_HEADER_BYTES ? self->mtu - PACKET_HEADER_BYTES : self->mtu;
+    gsize estimated = self->held_bytes + frame.map.size + 2 + 2 * (self->held->size() + 1);
+    if (!self->held->empty() &&
+        (self->held_duration + frame.duration > MIN(self->max_ptime, (guint64) OPUS_MAX_PACKET_DURATION) ||
+         estimated > payload_limit)) {
+        ret = flush_held(self);
+    }
+
+    if (opus_repacketizer_cat(self->repacketizer, frame.map.data, frame.map.size) != OPUS_OK) {
+        // Different mode, bandwidth or frame size: start a new packet
+        if (ret == GST_FLOW_OK) {
+            ret = flush_held(self);
+        }
+        if (opus_repacketizer_cat(self->repacketizer, frame.map.data, frame.map.size) != OPUS_OK) {
+            // Not something the repacketizer understands, pass it on alone
+            gst_buffer_unmap(buffer, &frame.map);
+            count_packet(self, gst_buffer_get_size(buffer));
+            GstFlowReturn pushed = gst_pad_push(self->srcpad, buffer);
+            return ret == GST_FLOW_OK ? pushed : ret;
+        }
+    }
+
+    self->held->push_back(frame);
+    self->held_duration += frame.duration;
+    self->held_bytes += frame.map.size;
+
+    if (ret == GST_FLOW_OK && self->held_duration >= self->ptime) {
+        ret = flush_held(self);
+    }
+    return ret;
+}
+
+static gboolean opus_aggregator_sink_event(GstPad *pad, GstObject *parent, GstEvent *event) {
+    OpusAggregator *self = OPUS_AGGREGATOR(parent);
+
+    switch (GST_EVENT_TYPE(event)) {
+        case GST_EVENT_EOS:
+        case GST_EVENT_SEGMENT:
+        case GST_EVENT_GAP:
+            // Held frames belong before whatever this event announces
+            flush_held(self);
+            break;
+        case GST_EVENT_FLUSH_STOP:
+            release_held(self);
+            break;
+        default:
+            break;
+    }
+
+    return gst_pad_event_default(pad, parent, event);
+}
+
+static gboolean opus_aggregator_src_query(GstPad *pad, GstObject *parent, GstQuery *query) {
+    OpusAggregator *self = OPUS_AGGREGATOR(parent);
+
+    if (GST_QUERY_TYPE(query) != GST_QUERY_LATENCY) {
+        return gst_pad_query_default(pad, parent, query);
+    }
+
+    if (!gst_pad_peer_query(self->sinkpad, query)) {
+        return FALSE;
+    }
+
+    // A frame can wait for up to ptime of later audio
+    gboolean live;
+    GstClockTime min, max;
+    gst_query_parse_latency(query, &live, &min, &max);
+    min += self->ptime;
+    if (GST_CLOCK_TIME_IS_VALID(max)) {
+        max += self->ptime;
+    }
+    gst_query_set_latency(query, live, min, max);
+    return TRUE;
+}
+
+static GstStateChangeReturn opus_aggregator_change_state(GstElement *element, GstStateChange transition) {
+    OpusAggregator *self = OPUS_AGGREGATOR(element);
+
+    GstStateChangeReturn ret = GST_ELEMENT_CLASS(opus_aggregator_parent_class)->change_state(element, transition);
+
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+        GST_PAD_STREAM_LOCK(self->sinkpad);
+        release_held(self);
+        GST_PAD_STREAM_UNLOCK(self->sinkpad);
+    }
+    return ret;
+}
+
+static void opus_aggregator_set_property(GObject *object, guint prop_id,
+                                         const GValue *value, GParamSpec *pspec) {
+    OpusAggregator *self = OPUS_AGGREGATOR(object);
+
+    switch (prop_id) {
+        case PROP_PTIME:
+            self->ptime = g_value_get_uint64(value);
+            break;
+        case PROP_MAX_PTIME:
+            self->max_ptime = g_value_get_uint64(value);
+            break;
+        case PROP_MTU:
+            self->mtu = g_value_get_uint(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+}
+
+static void opus_aggregator_get_property(GObject *object, guint prop_id,
+                                         GValue *value, GParamSpec *pspec) {
+    OpusAggregator *self = OPUS_AGGREGATOR(object);
+
+    switch (prop_id) {
+        case PROP_PTIME:
+            g_value_set_uint64(value, self->ptime);
+            return;
+        case PROP_MAX_PTIME:
+            g_value_set_uint64(value, self->max_ptime);
+            return;
+        case PROP_MTU:
+            g_value_set_uint(value, self->mtu);
+            return;
+        default:
+            break;
+    }
+
+    g_mutex_lock(&self->stats_lock);
+    switch (prop_id) {
+        case PROP_PACKETS:
+            g_value_set_uint64(value, self->packets);
+            break;
+        case PROP_PAYLOAD_BYTES:
+            g_value_set_uint64(value, self->payload_bytes);
+            break;
+        case PROP_PACKET_RATE:
+            g_value_set_double(value, self->packet_rate);
+            break;
+        case PROP_OVERHEAD_RATIO: {
+            guint64 header_bytes = self->packets * PACKET_HEADER_BYTES;
+            guint64 total = header_bytes + self->payload_bytes;
+            g_value_set_double(value, total > 0 ? header_bytes / (gdouble) total : 0.0);
+            break;
+        }
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&self->stats_lock);
+}
+
+static void opus_aggregator_finalize(GObject *object) {
+    OpusAggregator *self = OPUS_AGGREGATOR(object);
+
+    release_held(self);
+    delete self->held;
+    opus_repacketizer_destroy(self->repacketizer);
+    g_mutex_clear(&self->stats_lock);
+
+    G_OBJECT_CLASS(opus_aggregator_parent_class)->finalize(object);
+}
+
+static void opus_aggregator_class_init(OpusAggregatorClass *klass) {
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->set_property = opus_aggregator_set_property;
+    gobject_class->get_property = opus_aggregator_get_property;
+    gobject_class->finalize = opus_aggregator_finalize;
+    element_class->change_state = opus_aggregator_change_state;
+
+    GParamFlags readwrite = (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS);
+    GParamFlags readable = (GParamFlags) (G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+
+    g_object_class_install_property(gobject_class, PROP_PTIME,
+        g_param_spec_uint64("ptime", "ptime",
+            "Audio per packet in nanoseconds (0 = one frame per packet)",
+            0, OPUS_MAX_PACKET_DURATION, DEFAULT_PTIME, readwrite));
+    g_object_class_install_property(gobject_class, PROP_MAX_PTIME,
+        g_param_spec_uint64("max-ptime", "Max ptime",
+            "Most audio a packet may carry in nanoseconds",
+            0, OPUS_MAX_PACKET_DURATION, DEFAULT_MAX_PTIME, readwrite));
+    g_object_class_install_property(gobject_class, PROP_MTU,
+        g_param_spec_uint("mtu", "MTU",
+            "Largest IP packet to produce, headers included", 128, 65535, DEFAULT_MTU, readwrite));
+    g_object_class_install_property(gobject_class, PROP_PACKETS,
+        g_param_spec_uint64("packets", "Packets",
+            "Packets pushed", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_PAYLOAD_BYTES,
+        g_param_spec_uint64("payload-bytes", "Payload bytes",
+            "Opus bytes pushed", 0, G_MAXUINT64, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_PACKET_RATE,
+        g_param_spec_double("packet-rate", "Packet rate",
+            "Packets per second over the last full second", 0, G_MAXDOUBLE, 0, readable));
+    g_object_class_install_property(gobject_class, PROP_OVERHEAD_RATIO,
+        g_param_spec_double("overhead-ratio", "Overhead ratio",
+            "Share of sent bytes spent on IP/UDP/RTP headers", 0, 1, 0, readable));
+
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+    gst_element_class_set_static_metadata(element_class,
+        "Opus frame aggregator", "Codec/Muxer/Audio",
+        "Joins consecutive Opus frames into multi-frame packets up to a ptime and MTU",
+        "HeavenWaves");
+}
+
+static void opus_aggregator_init(OpusAggregator *self) {
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, opus_aggregator_chain);
+    gst_pad_set_event_function(self->sinkpad, opus_aggregator_sink_event);
+    GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+    GST_PAD_SET_PROXY_ALLOCATION(self->sinkpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    gst_pad_set_query_function(self->srcpad, opus_aggregator_src_query);
+    GST_PAD_SET_PROXY_CAPS(self->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+
+    self->repacketizer = opus_repacketizer_create();
+    self->held = new std::vector<HeldFrame>();
+    self->ptime = DEFAULT_PTIME;
+    self->max_ptime = DEFAULT_MAX_PTIME;
+    self->mtu = DEFAULT_MTU;
+    g_mutex_init(&self->stats_lock);
+}
+
+extern "C" {
+
+/**
+ * Register opusaggregate with the element registry
+ * Called from native-audio-bridge.cpp before a pipeline uses it
+ */
+gboolean register_opus_aggregator(void) {
+    return gst_element_register(nullptr, "opusaggregate", GST_RANK_NONE, opus_aggregator_get_type());
+}
+
+} // extern "C"
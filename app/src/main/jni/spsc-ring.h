@@ -0,0 +1,88 @@
+/*
+ * spsc-ring.h
+ *
+ * Capture-to-pusher handoff queue, kept free of GLib so it builds and is
+ * tested on the host
+ */
+
+#ifndef HEAVENWAVES_SPSC_RING_H
+#define HEAVENWAVES_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * SpscRing - Bounded lock-free single-producer/single-consumer queue
+ *
+ * push() is only ever called from the capture (JNI) thread and pop() only
+ * from the pusher thread. Each side owns one index and publishes it with
+ * release ordering, so neither side waits on the other.
+ */
+template <typename T>
+class SpscRing {
+    private:
+        std::vector<T> slots;
+        std::atomic<size_t> head{0}; // next slot to write, owned by producer
+        std::atomic<size_t> tail{0}; // next slot to read, owned by consumer
+
+    public:
+        explicit SpscRing(size_t capacity) : slots(capacity + 1) {}
+
+        bool push(const T &item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t next = (h + 1) % slots.size();
+
+            if (next == tail.load(std::memory_order_acquire)) {
+                return false; // full
+            }
+
+            slots[h] = item;
+            head.store(next, std::memory_order_release);
+            return true;
+        }
+
+        bool pop(T &item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+
+            if (t == head.load(std::memory_order_acquire)) {
+                return false; // empty
+            }
+
+            item = slots[t];
+            tail.store((t + 1) % slots.size(), std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        size_t size() const {
+            size_t h = head.load(std::memory_order_acquire);
+            size_t t = tail.load(std::memory_order_acquire);
+            return (h + slots.size() - t) % slots.size();
+        }
+
+        size_t capacity() const {
+            return slots.size() - 1;
+        }
+};
+
+/**
+ * Ring slots that hold capacity_ms of audio in whole feeds of feed_size
+ * bytes (a batched feed takes one slot for all of its periods). Never
+ * fewer than two; four while the format isn't known.
+ */
+inline size_t ring_slots(uint64_t bytes_per_second, size_t feed_size, int capacity_ms) {
+    if (feed_size == 0 || bytes_per_second == 0) {
+        return 4;
+    }
+
+    uint64_t capacity_bytes = bytes_per_second * (uint64_t) std::max(capacity_ms, 0) / 1000;
+    return (size_t) std::max<uint64_t>((capacity_bytes + feed_size - 1) / feed_size, 2);
+}
+
+#endif // HEAVENWAVES_SPSC_RING_H
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "bitrate-controller.h"
+
+namespace {
+
+// RTCP fraction lost is loss * 256
+const uint8_t NO_LOSS = 0;
+const uint8_t LOSS_6_PERCENT = 15;
+const uint8_t LOSS_25_PERCENT = 64;
+
+const double CLEAN_JITTER = 5.0;
+const double MIDDLING_JITTER = 20.0;
+const double CONGESTED_JITTER = 40.0;
+
+}
+
+TEST(BitrateControllerTest, StartsAtMaxWithoutLoss) {
+    BitrateController controller(16000, 64000);
+
+    EXPECT_EQ(controller.get_bitrate(), 64000);
+    EXPECT_EQ(controller.get_loss_percentage(), 0);
+}
+
+TEST(BitrateControllerTest, FirstReportSeedsTheSmoothedLoss) {
+    BitrateController controller(16000, 64000);
+
+    controller.on_report(LOSS_25_PERCENT, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_loss_percentage(), 25);
+}
+
+TEST(BitrateControllerTest, SmoothsLossAcrossReports) {
+    BitrateController controller(16000, 64000);
+    controller.on_report(LOSS_25_PERCENT, CLEAN_JITTER);
+
+    // 0.3 * 0 + 0.7 * 25%
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_loss_percentage(), 18);
+
+    // 0.3 * 25% + 0.7 * 17.5%
+    controller.on_report(LOSS_25_PERCENT, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_loss_percentage(), 20);
+}
+
+TEST(BitrateControllerTest, IgnoresOnePointLossChanges) {
+    BitrateController controller(16000, 64000);
+    // 10%, then decaying by 0.7 per clean report
+    controller.on_report(26, CLEAN_JITTER);
+    ASSERT_EQ(controller.get_loss_percentage(), 10);
+
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 7.1%
+    EXPECT_EQ(controller.get_loss_percentage(), 7);
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 5.0%
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 3.5%
+    EXPECT_EQ(controller.get_loss_percentage(), 3);
+
+    // 2.4% and 1.7% both round to 2, a single point off
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_loss_percentage(), 3);
+
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 1.2%
+    EXPECT_EQ(controller.get_loss_percentage(), 1);
+
+    // Dropping all the way to zero always goes through
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 0.8%
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 0.6%
+    EXPECT_EQ(controller.get_loss_percentage(), 1);
+    controller.on_report(NO_LOSS, CLEAN_JITTER); // 0.4%
+    EXPECT_EQ(controller.get_loss_percentage(), 0);
+}
+
+TEST(BitrateControllerTest, CongestionStepsDownStraightAway) {
+    BitrateController controller(16000, 64000);
+
+    EXPECT_TRUE(controller.on_report(NO_LOSS, CONGESTED_JITTER));
+    EXPECT_EQ(controller.get_bitrate(), 51200);
+
+    // Loss above 5% but not above 10%: the same 0.8 step
+    BitrateController lossy(16000, 64000);
+    lossy.on_report(LOSS_6_PERCENT, CLEAN_JITTER);
+    EXPECT_EQ(lossy.get_bitrate(), 51200);
+}
+
+TEST(BitrateControllerTest, HeavyLossStepsDownHarder) {
+    BitrateController controller(16000, 64000);
+
+    controller.on_report(LOSS_25_PERCENT, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_bitrate(), 38400);
+}
+
+TEST(BitrateControllerTest, StepsUpOnlyAfterThreeCleanReports) {
+    BitrateController controller(16000, 64000);
+    controller.on_report(NO_LOSS, CONGESTED_JITTER);
+    ASSERT_EQ(controller.get_bitrate(), 51200);
+
+    EXPECT_FALSE(controller.on_report(NO_LOSS, CLEAN_JITTER));
+    EXPECT_FALSE(controller.on_report(NO_LOSS, CLEAN_JITTER));
+    EXPECT_EQ(controller.get_bitrate(), 51200);
+
+    EXPECT_TRUE(controller.on_report(NO_LOSS, CLEAN_JITTER));
+    EXPECT_EQ(controller.get_bitrate(), 56320);
+
+    // The count starts over after each step
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_bitrate(), 56320);
+}
+
+TEST(BitrateControllerTest, InBetweenReportResetsTheCleanCount) {
+    BitrateController controller(16000, 64000);
+    controller.on_report(NO_LOSS, CONGESTED_JITTER);
+
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    // Neither congested nor clean: hold the bitrate, start counting again
+    EXPECT_FALSE(controller.on_report(NO_LOSS, MIDDLING_JITTER));
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_bitrate(), 51200);
+
+    controller.on_report(NO_LOSS, CLEAN_JITTER);
+    EXPECT_EQ(controller.get_bitrate(), 56320);
+}
+
+TEST(BitrateControllerTest, ClampsToMin) {
+    BitrateController controller(16000, 64000);
+
+    for (int i = 0; i < 10; i++) {
+        controller.on_report(LOSS_25_PERCENT, CONGESTED_JITTER);
+    }
+    EXPECT_EQ(controller.get_bitrate(), 16000);
+
+    // Already at the floor: nothing left to tell the encoder
+    EXPECT_FALSE(controller.on_report(LOSS_25_PERCENT, CONGESTED_JITTER));
+}
+
+TEST(BitrateControllerTest, ClampsToMax) {
+    BitrateController controller(16000, 64000);
+    controller.on_report(NO_LOSS, CONGESTED_JITTER);
+
+    // 51200 -> 56320 -> 61952 -> 64000 rather than 68147
+    for (int i = 0; i < 9; i++) {
+        controller.on_report(NO_LOSS, CLEAN_JITTER);
+    }
+    EXPECT_EQ(controller.get_bitrate(), 64000);
+
+    for (int i = 0; i < 3; i++) {
+        EXPECT_FALSE(controller.on_report(NO_LOSS, CLEAN_JITTER));
+    }
+    EXPECT_EQ(controller.get_bitrate(), 64000);
+}
+
+TEST(BitrateControllerTest, MinAboveMaxPinsToMax) {
+    BitrateController controller(64000, 32000);
+
+    controller.on_report(LOSS_25_PERCENT, CONGESTED_JITTER);
+    EXPECT_EQ(controller.get_bitrate(), 32000);
+}
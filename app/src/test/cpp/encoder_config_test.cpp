@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+#include "encoder-config.h"
+
+namespace {
+
+/**
+ * Pipeline options stand-in: every value is kept as a string and parsed
+ * by the getter, which like GstStructure leaves absent keys alone
+ */
+class FakeOptions {
+    private:
+        std::map<std::string, std::string> values;
+
+    public:
+        FakeOptions &set(const std::string &key, const std::string &value) {
+            values[key] = value;
+            return *this;
+        }
+
+        bool get_int(const char *key, int &value) const {
+            auto it = values.find(key);
+            if (it == values.end()) {
+                return false;
+            }
+            value = std::stoi(it->second);
+            return true;
+        }
+
+        bool get_uint(const char *key, unsigned &value) const {
+            auto it = values.find(key);
+            if (it == values.end()) {
+                return false;
+            }
+            value = (unsigned) std::stoul(it->second);
+            return true;
+        }
+
+        bool get_bool(const char *key, bool &value) const {
+            auto it = values.find(key);
+            if (it == values.end()) {
+                return false;
+            }
+            value = it->second == "true";
+            return true;
+        }
+
+        const char *get_string(const char *key) const {
+            auto it = values.find(key);
+            return it == values.end() ? nullptr : it->second.c_str();
+        }
+};
+
+EncoderConfig preset(const std::string &name) {
+    EncoderConfig config;
+    EXPECT_TRUE(config.load_preset(name)) << name;
+    return config;
+}
+
+}
+
+TEST(EncoderConfigTest, DefaultPresetKeepsOpusencDefaults) {
+    EncoderConfig config = preset("default");
+
+    EXPECT_EQ(config.frame_size_us, 20000);
+    EXPECT_EQ(config.frame_size_nick(), "20");
+    EXPECT_EQ(config.complexity, 10);
+    EXPECT_EQ(config.bitrate_type, "cbr");
+    EXPECT_EQ(config.audio_type, "generic");
+    EXPECT_FALSE(config.inband_fec);
+    EXPECT_EQ(config.packet_loss_percentage, 0);
+    EXPECT_FALSE(config.dtx);
+    EXPECT_EQ(config.max_payload_size, 4000u);
+    EXPECT_EQ(config.fec, "none");
+}
+
+TEST(EncoderConfigTest, UltraLowLatencyPreset) {
+    EncoderConfig config = preset("ultra-low-latency");
+
+    EXPECT_EQ(config.frame_size_us, 5000);
+    EXPECT_EQ(config.frame_size_nick(), "5");
+    EXPECT_EQ(config.complexity, 5);
+    EXPECT_EQ(config.audio_type, "restricted-lowdelay");
+    EXPECT_EQ(config.max_payload_size, 1200u);
+    EXPECT_EQ(config.fec, "none");
+}
+
+TEST(EncoderConfigTest, BalancedPreset) {
+    EncoderConfig config = preset("balanced");
+
+    EXPECT_EQ(config.frame_size_us, 10000);
+    EXPECT_EQ(config.complexity, 7);
+    EXPECT_EQ(config.bitrate_type, "constrained-vbr");
+    EXPECT_TRUE(config.inband_fec);
+    EXPECT_EQ(config.packet_loss_percentage, 5);
+    EXPECT_EQ(config.fec, "none");
+}
+
+TEST(EncoderConfigTest, LossyLinkPreset) {
+    EncoderConfig config = preset("lossy-link");
+
+    EXPECT_EQ(config.frame_size_us, 10000);
+    EXPECT_EQ(config.complexity, 7);
+    EXPECT_EQ(config.bitrate_type, "constrained-vbr");
+    EXPECT_TRUE(config.inband_fec);
+    EXPECT_EQ(config.packet_loss_percentage, 10);
+    EXPECT_EQ(config.fec, "red");
+    EXPECT_EQ(config.fec_distance, 1u);
+}
+
+TEST(EncoderConfigTest, LowCpuPreset) {
+    EncoderConfig config = preset("low-cpu");
+
+    EXPECT_EQ(config.frame_size_us, 20000);
+    EXPECT_EQ(config.complexity, 2);
+    EXPECT_EQ(config.bitrate_type, "cbr");
+    EXPECT_FALSE(config.inband_fec);
+}
+
+TEST(EncoderConfigTest, UnknownPresetIsRejected) {
+    EncoderConfig config;
+    ASSERT_TRUE(config.load_preset("lossy-link"));
+
+    EXPECT_FALSE(config.load_preset("lossless"));
+    EXPECT_FALSE(config.load_preset(""));
+    // Whatever was loaded before doesn't leak through
+    EXPECT_EQ(config.describe(), EncoderConfig().describe());
+}
+
+TEST(EncoderConfigTest, LoadingAPresetStartsFromDefaults) {
+    EncoderConfig config = preset("ultra-low-latency");
+    ASSERT_TRUE(config.load_preset("low-cpu"));
+
+    EXPECT_EQ(config.audio_type, "generic");
+    EXPECT_EQ(config.max_payload_size, 4000u);
+}
+
+TEST(EncoderConfigTest, OverridesBeatThePreset) {
+    EncoderConfig config = preset("lossy-link");
+    config.apply_overrides(FakeOptions()
+        .set("encoder-frame-size-us", "2500")
+        .set("encoder-complexity", "3")
+        .set("encoder-bitrate-type", "vbr")
+        .set("encoder-audio-type", "voice")
+        .set("encoder-inband-fec", "false")
+        .set("encoder-packet-loss-percentage", "20")
+        .set("encoder-dtx", "true")
+        .set("encoder-max-payload-size", "900")
+        .set("encoder-fec", "ulpfec")
+        .set("encoder-fec-distance", "2")
+        .set("encoder-fec-percentage", "25"));
+
+    EXPECT_EQ(config.frame_size_us, 2500);
+    EXPECT_EQ(config.frame_size_nick(), "2.5");
+    EXPECT_EQ(config.complexity, 3);
+    EXPECT_EQ(config.bitrate_type, "vbr");
+    EXPECT_EQ(config.audio_type, "voice");
+    EXPECT_FALSE(config.inband_fec);
+    EXPECT_EQ(config.packet_loss_percentage, 20);
+    EXPECT_TRUE(config.dtx);
+    EXPECT_EQ(config.max_payload_size, 900u);
+    EXPECT_EQ(config.fec, "ulpfec");
+    EXPECT_EQ(config.fec_distance, 2u);
+    EXPECT_EQ(config.fec_percentage, 25u);
+}
+
+TEST(EncoderConfigTest, AbsentOverridesKeepThePreset) {
+    EncoderConfig config = preset("balanced");
+    config.apply_overrides(FakeOptions()
+        .set("encoder-complexity", "9")
+        .set("unrelated", "1"));
+
+    EXPECT_EQ(config.complexity, 9);
+    EXPECT_EQ(config.frame_size_us, 10000);
+    EXPECT_EQ(config.bitrate_type, "constrained-vbr");
+    EXPECT_TRUE(config.inband_fec);
+    EXPECT_EQ(config.packet_loss_percentage, 5);
+
+    // Nothing set at all
+    EncoderConfig untouched = preset("balanced");
+    untouched.apply_overrides(FakeOptions());
+    EXPECT_EQ(untouched.describe(), preset("balanced").describe());
+}
+
+TEST(EncoderConfigTest, NoFecAddsNoLatency) {
+    EXPECT_EQ(preset("default").fec_latency_ms(), 0u);
+    EXPECT_EQ(preset("balanced").fec_latency_ms(), 0u);
+}
+
+TEST(EncoderConfigTest, RedLatencyIsTheRepeatedFrames) {
+    EXPECT_EQ(preset("lossy-link").fec_latency_ms(), 10u);
+
+    EncoderConfig config = preset("default");
+    config.apply_overrides(FakeOptions().set("encoder-fec", "red").set("encoder-fec-distance", "2"));
+    EXPECT_EQ(config.fec_latency_ms(), 40u);
+}
+
+TEST(EncoderConfigTest, UlpfecLatencyCoversTrailingRepairPackets) {
+    EncoderConfig config = preset("balanced");
+    config.apply_overrides(FakeOptions().set("encoder-fec", "ulpfec"));
+    // No repair packets without a percentage
+    EXPECT_EQ(config.fec_latency_ms(), 0u);
+
+    config.apply_overrides(FakeOptions().set("encoder-fec-percentage", "10"));
+    EXPECT_EQ(config.fec_latency_ms(), 20u);
+
+    config.apply_overrides(FakeOptions().set("encoder-fec-distance", "0"));
+    EXPECT_EQ(config.fec_latency_ms(), 20u);
+
+    config.apply_overrides(FakeOptions().set("encoder-fec-distance", "3"));
+    EXPECT_EQ(config.fec_latency_ms(), 60u);
+}
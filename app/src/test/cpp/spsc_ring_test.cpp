@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "spsc-ring.h"
+
+TEST(SpscRingTest, StartsEmptyWithRequestedCapacity) {
+    SpscRing<int> ring(3);
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.size(), 0u);
+    EXPECT_EQ(ring.capacity(), 3u);
+
+    int item;
+    EXPECT_FALSE(ring.pop(item));
+}
+
+TEST(SpscRingTest, PopsInPushOrder) {
+    SpscRing<int> ring(4);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ring.push(i));
+    }
+    EXPECT_EQ(ring.size(), 4u);
+
+    int item;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(ring.pop(item));
+        EXPECT_EQ(item, i);
+    }
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, WrapsAroundKeepingOrderAndSize) {
+    SpscRing<int> ring(3);
+    int next_in = 0;
+    int next_out = 0;
+    int item;
+
+    // Enough rounds for both indices to wrap several times
+    for (int round = 0; round < 10; round++) {
+        while (ring.push(next_in)) {
+            next_in++;
+        }
+        EXPECT_EQ(ring.size(), 3u);
+
+        ASSERT_TRUE(ring.pop(item));
+        EXPECT_EQ(item, next_out++);
+        ASSERT_TRUE(ring.pop(item));
+        EXPECT_EQ(item, next_out++);
+        EXPECT_EQ(ring.size(), 1u);
+    }
+
+    while (ring.pop(item)) {
+        EXPECT_EQ(item, next_out++);
+    }
+    EXPECT_EQ(next_out, next_in);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, FullRingRefusesPushUntilPopped) {
+    SpscRing<int> ring(2);
+    ASSERT_TRUE(ring.push(1));
+    ASSERT_TRUE(ring.push(2));
+
+    // The capture thread counts each of these as an overrun
+    EXPECT_FALSE(ring.push(3));
+    EXPECT_FALSE(ring.push(4));
+    EXPECT_EQ(ring.size(), 2u);
+
+    int item;
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, 1);
+    EXPECT_TRUE(ring.push(5));
+
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, 2);
+    ASSERT_TRUE(ring.pop(item));
+    EXPECT_EQ(item, 5);
+}
+
+TEST(SpscRingTest, OverrunsAccountForEveryItemAcrossThreads) {
+    const int total = 200000;
+    SpscRing<int> ring(8);
+    int received = 0;
+    bool ordered = true;
+
+    std::thread consumer([&]() {
+        int last = -1;
+        int item;
+        while (true) {
+            if (!ring.pop(item)) {
+                continue;
+            }
+            if (item < 0) {
+                break;
+            }
+            ordered = ordered && item > last;
+            last = item;
+            received++;
+        }
+    });
+
+    // Like enqueue(): never wait, count what doesn't fit
+    int overruns = 0;
+    for (int i = 0; i < total; i++) {
+        if (!ring.push(i)) {
+            overruns++;
+        }
+    }
+    while (!ring.push(-1)) {
+    }
+    consumer.join();
+
+    EXPECT_TRUE(ordered);
+    EXPECT_EQ(received + overruns, total);
+    EXPECT_TRUE(ring.empty());
+}
+
+TEST(RingSlotsTest, HoldsCapacityInWholeFeeds) {
+    // 48 kHz stereo 16-bit: 192000 B/s, 10 ms periods of 1920 B
+    EXPECT_EQ(ring_slots(192000, 1920, 200), 20u);
+    // A partial feed still needs a whole slot
+    EXPECT_EQ(ring_slots(192000, 1920, 205), 21u);
+}
+
+TEST(RingSlotsTest, BatchedFeedTakesOneSlot) {
+    // Four 10 ms periods per feed
+    EXPECT_EQ(ring_slots(192000, 4 * 1920, 200), 5u);
+    EXPECT_EQ(ring_slots(192000, 4 * 1920, 210), 6u);
+}
+
+TEST(RingSlotsTest, NeverFewerThanTwo) {
+    EXPECT_EQ(ring_slots(192000, 1920, 1), 2u);
+    EXPECT_EQ(ring_slots(192000, 1920, 0), 2u);
+    EXPECT_EQ(ring_slots(192000, 16 * 1920, 20), 2u);
+}
+
+TEST(RingSlotsTest, UnknownFormatFallsBackToFour) {
+    EXPECT_EQ(ring_slots(0, 1920, 200), 4u);
+    EXPECT_EQ(ring_slots(192000, 0, 200), 4u);
+}